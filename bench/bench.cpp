@@ -0,0 +1,379 @@
+// Micro- and macro-benchmarks of the parse, compile and evaluation paths.
+//
+//     math_parser_bench [--format=json|csv] [--output=FILE] [--filter=TEXT] [--min-time=SECONDS] [--repetitions=N]
+//
+// Every benchmark is calibrated to run for at least --min-time per repetition, then repeated; the median, minimum
+// and maximum time per iteration are reported. Inputs come from a fixed seed, so runs are comparable across builds.
+
+#include "../include/math_parser/fused.hpp"
+#include "../include/math_parser/math_parser.hpp"
+#include "../include/math_parser/parameterized.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+    using namespace InputHandling;
+    using InputHandling::_Internal::Lexer;
+    using InputHandling::_Internal::to_rpn;
+
+    struct Formula {
+        std::string name;
+        std::string text;
+    };
+
+    // Sum of `terms` varied terms, to measure how parsing scales with length.
+    std::string long_formula(std::size_t terms) {
+        const char *pieces[] = {"sin(x*%zu)", "cos(y+%zu)", "x^2/%zu", "max(x,y)*%zu", "exp(-x*y/%zu)"};
+        std::string text;
+        char buffer[64];
+        for (std::size_t i = 0u; i < terms; ++i) {
+            std::snprintf(buffer, sizeof buffer, pieces[i % 5u], i + 1u);
+            text += (i == 0u ? "" : " + ");
+            text += buffer;
+        }
+        return text;
+    }
+
+    // `count` variations on one dashboard-style formula, which share most of their subexpressions.
+    std::vector<std::string> related_formulas(std::size_t count) {
+        std::vector<std::string> texts;
+        for (std::size_t i = 0u; i < count; ++i) {
+            char buffer[160];
+            std::snprintf(buffer, sizeof buffer, "sin(x*y) * exp(-(x*x + y*y)/2) * %zu + cos(x - y) / %zu + x*%zu",
+                          i + 1u, i + 2u, i);
+            texts.push_back(buffer);
+        }
+        return texts;
+    }
+
+    const std::vector<Formula> &corpus() {
+        static const std::vector<Formula> formulas{
+            {"linear", "2*x + 3*y - 1"},
+            {"polynomial", "x^3 - 3*x*y^2 + 0.5*y - 1"},
+            {"trig", "sin(x)*cos(y) + tan(x/7)"},
+            {"ripple", "sin(x*x + y*y) / (1 + x*x + y*y)"},
+            {"gaussian", "exp(-(x^2 + y^2)/2)"},
+            {"shader", "smoothstep(0, 1, mix(sin(x*y), cos(x*y), 0.5))"},
+            {"piecewise", "clamp(floor(x) + fract(y), -1, 1) * step(0, x*y)"},
+            {"hyperbolic", "tanh(x) * sech(y) + asinh(x*y)"},
+            {"long_50", long_formula(50u)},
+        };
+        return formulas;
+    }
+
+    struct Result {
+        std::string name;
+        std::size_t iterations; // Per repetition.
+        std::size_t items;      // Work items (characters, lexemes or points) per iteration.
+        double median_ns;       // Per iteration.
+        double min_ns;
+        double max_ns;
+    };
+
+    struct Options {
+        std::string format = "json";
+        std::string output;
+        std::string filter;
+        double min_time         = 0.1;
+        std::size_t repetitions = 5u;
+    };
+
+    // Keeps results alive so the compiler cannot discard the work that produced them.
+    volatile double sink;
+
+    class Runner {
+      public:
+        explicit Runner(const Options &options) : options{options} {}
+
+        void run(const std::string &name, std::size_t items, const std::function<void()> &body) {
+            if (name.find(options.filter) == std::string::npos) { return; }
+
+            using Clock      = std::chrono::steady_clock;
+            const auto timed = [&](std::size_t iterations) {
+                const auto start = Clock::now();
+                for (std::size_t i = 0u; i < iterations; ++i) { body(); }
+                return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            };
+
+            // Grow the iteration count until one repetition takes at least min_time.
+            std::size_t iterations = 1u;
+            for (double elapsed = timed(iterations); elapsed < options.min_time * 1e9; elapsed = timed(iterations)) {
+                const double scale = elapsed > 0. ? options.min_time * 1e9 / elapsed : 10.;
+                iterations         = std::max(iterations + 1u, static_cast<std::size_t>(iterations * scale * 1.2));
+            }
+
+            std::vector<double> samples;
+            for (std::size_t r = 0u; r < options.repetitions; ++r) {
+                samples.push_back(timed(iterations) / static_cast<double>(iterations));
+            }
+            std::sort(samples.begin(), samples.end());
+
+            results.push_back({name, iterations, items, samples[samples.size() / 2u], samples.front(), samples.back()});
+            std::cerr << name << ": " << results.back().median_ns << " ns\n";
+        }
+
+        void report(std::ostream &out) const {
+            if (options.format == "csv") {
+                out << "name,iterations,items,median_ns,min_ns,max_ns,items_per_second\n";
+                for (const auto &r : results) {
+                    out << r.name << ',' << r.iterations << ',' << r.items << ',' << r.median_ns << ',' << r.min_ns
+                        << ',' << r.max_ns << ',' << items_per_second(r) << '\n';
+                }
+                return;
+            }
+
+            out << "{\n  \"context\": {\"compiler\": \"" << compiler() << "\", \"simd\": \"" << simd()
+                << "\", \"hardware_concurrency\": " << std::thread::hardware_concurrency()
+                << ", \"repetitions\": " << options.repetitions << "},\n  \"benchmarks\": [\n";
+            for (std::size_t i = 0u; i < results.size(); ++i) {
+                const auto &r = results[i];
+                out << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                    << ", \"items\": " << r.items << ", \"median_ns\": " << r.median_ns << ", \"min_ns\": " << r.min_ns
+                    << ", \"max_ns\": " << r.max_ns << ", \"items_per_second\": " << items_per_second(r) << '}'
+                    << (i + 1u < results.size() ? ",\n" : "\n");
+            }
+            out << "  ]\n}\n";
+        }
+
+      private:
+        static double items_per_second(const Result &r) { return r.items * 1e9 / r.median_ns; }
+
+        static std::string compiler() {
+#if defined(__clang__)
+            return "clang " __clang_version__;
+#elif defined(__GNUC__)
+            return "gcc " __VERSION__;
+#else
+            return "unknown";
+#endif
+        }
+
+        static std::string simd() {
+#if defined(__AVX2__)
+            return "avx2";
+#elif defined(__SSE2__)
+            return "sse2";
+#else
+            return "scalar";
+#endif
+        }
+
+        const Options &options;
+        std::vector<Result> results;
+    };
+
+    bool parse_options(int argc, char **argv, Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            const auto value           = [&](std::string_view flag) { return std::string{arg.substr(flag.size())}; };
+
+            if (arg.starts_with("--format=")) {
+                options.format = value("--format=");
+            } else if (arg.starts_with("--output=")) {
+                options.output = value("--output=");
+            } else if (arg.starts_with("--filter=")) {
+                options.filter = value("--filter=");
+            } else if (arg.starts_with("--min-time=")) {
+                options.min_time = std::stod(value("--min-time="));
+            } else if (arg.starts_with("--repetitions=")) {
+                options.repetitions = std::max<std::size_t>(1u, std::stoul(value("--repetitions=")));
+            } else {
+                std::cerr << "Unknown argument: " << arg << '\n';
+                return false;
+            }
+        }
+        return options.format == "json" || options.format == "csv";
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (parse_options(argc, argv, options) == false) {
+        std::cerr << "usage: math_parser_bench [--format=json|csv] [--output=FILE] [--filter=TEXT] "
+                     "[--min-time=SECONDS] [--repetitions=N]\n";
+        return 2;
+    }
+
+    constexpr std::size_t num_points = 4096u;
+    constexpr std::size_t grid_side  = 512u;
+
+    std::mt19937_64 rng{42u};
+    std::uniform_real_distribution<double> coordinate{-4., 4.};
+    std::vector<double> xs(num_points), ys(num_points), out(grid_side * grid_side);
+    for (auto &x : xs) { x = coordinate(rng); }
+    for (auto &y : ys) { y = coordinate(rng); }
+    const std::vector<float> xs_single(xs.begin(), xs.end()), ys_single(ys.begin(), ys.end());
+    std::vector<float> out_single(out.size());
+
+    Runner runner{options};
+
+    // Front end, on the corpus and on one very long expression.
+    auto formulas = corpus();
+    formulas.push_back({"long_1000", long_formula(1000u)});
+    for (const auto &formula : formulas) {
+        runner.run("lex/" + formula.name, formula.text.size(), [&] {
+            Lexer lexer{formula.text};
+            std::size_t count = 0u;
+            while (lexer.done() == false) { count += lexer.next().length; }
+            sink = static_cast<double>(count);
+        });
+        runner.run("to_rpn/" + formula.name, formula.text.size(), [&] {
+            sink = static_cast<double>(to_rpn(formula.text).size());
+        });
+
+        const auto rpn = to_rpn(formula.text);
+        runner.run("compile/" + formula.name, rpn.size(), [&] {
+            sink = static_cast<double>(ParsedFunction{rpn}.program().code.size());
+        });
+        runner.run("parse/" + formula.name, formula.text.size(), [&] {
+            sink = static_cast<double>(ShuntingYardAlgorithm::parse_text_input(formula.text).program().code.size());
+        });
+    }
+
+    // Rejecting malformed formulas, which fail in the lexer, the shunting-yard and lowering, by exception and by
+    // ParseResult.
+    const std::string_view malformed[] = {"sin(x + y * 2", "x * * y", "foo(x) + 1", "max(x, y, 1)"};
+    runner.run("reject/throw", std::size(malformed), [&] {
+        std::size_t rejected = 0u;
+        for (const auto text : malformed) {
+            try {
+                ShuntingYardAlgorithm::parse_text_input(text);
+            } catch (const std::runtime_error &) { ++rejected; }
+        }
+        sink = static_cast<double>(rejected);
+    });
+    runner.run("reject/try", std::size(malformed), [&] {
+        std::size_t rejected = 0u;
+        for (const auto text : malformed) { rejected += ShuntingYardAlgorithm::try_parse_text_input(text) ? 0u : 1u; }
+        sink = static_cast<double>(rejected);
+    });
+
+    // Evaluation paths on the representative corpus.
+    for (const auto &formula : corpus()) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(formula.text);
+
+        runner.run("eval/" + formula.name, num_points, [&] {
+            double sum = 0.;
+            for (std::size_t i = 0u; i < num_points; ++i) { sum += function.eval(xs[i], ys[i]); }
+            sink = sum;
+        });
+        runner.run("eval_batch/" + formula.name, num_points, [&] {
+            function.eval_batch(xs, ys, std::span{out}.first(num_points));
+            sink = out[0];
+        });
+        runner.run("eval_grid/" + formula.name, grid_side * grid_side, [&] {
+            function.eval_grid(-4., 4., grid_side, -4., 4., grid_side, out);
+            sink = out[0];
+        });
+
+        const auto single = ShuntingYardAlgorithm::parse_text_input(formula.text, Precision::Single);
+        runner.run("eval_batch_f32/" + formula.name, num_points, [&] {
+            single.eval_batch(xs_single, ys_single, std::span{out_single}.first(num_points));
+            sink = out_single[0];
+        });
+        runner.run("eval_grid_f32/" + formula.name, grid_side * grid_side, [&] {
+            single.eval_grid(-4., 4., grid_side, -4., 4., grid_side, std::span{out_single});
+            sink = out_single[0];
+        });
+
+        const auto fast = ShuntingYardAlgorithm::parse_text_input(formula.text, Precision::Double, Accuracy::Fast);
+        runner.run("eval_batch_fast/" + formula.name, num_points, [&] {
+            fast.eval_batch(xs, ys, std::span{out}.first(num_points));
+            sink = out[0];
+        });
+    }
+
+    // Many related formulas over the same points, one by one and fused into a single program.
+    {
+        constexpr std::size_t num_related = 20u;
+
+        std::vector<ParsedFunction> functions;
+        for (const auto &text : related_formulas(num_related)) {
+            functions.push_back(ShuntingYardAlgorithm::parse_text_input(text));
+        }
+        const FusedFunction fused{functions};
+
+        std::vector<std::vector<double>> results(num_related, std::vector<double>(num_points));
+        std::vector<std::span<double>> outs(results.begin(), results.end());
+
+        runner.run("eval_related/separate_20", num_points * num_related, [&] {
+            for (std::size_t k = 0u; k < num_related; ++k) { functions[k].eval_batch(xs, ys, outs[k]); }
+            sink = results[0][0];
+        });
+        runner.run("eval_related/fused_20", num_points * num_related, [&] {
+            fused.eval_batch(xs, ys, outs);
+            sink = results[0][0];
+        });
+    }
+
+    // A formula over table columns, row by row and streamed column-wise.
+    {
+        const std::string_view names[]{"price", "qty", "rate", "days"};
+        const auto function = ShuntingYardAlgorithm::parse_text_input(
+            "price * qty * (1 + rate) ^ (days / 365) - max(price * qty - 100, 0) * 0.05", names);
+
+        std::vector<std::vector<double>> table(std::size(names), std::vector<double>(num_points));
+        for (auto &column : table) {
+            for (auto &value : column) { value = std::abs(coordinate(rng)); }
+        }
+        const std::vector<std::span<const double>> columns(table.begin(), table.end());
+
+        runner.run("eval_columns/rows", num_points, [&] {
+            double sum = 0.;
+            for (std::size_t i = 0u; i < num_points; ++i) {
+                const double row[]{table[0][i], table[1][i], table[2][i], table[3][i]};
+                sum += function.eval(row);
+            }
+            sink = sum;
+        });
+        runner.run("eval_columns/columns", num_points, [&] {
+            function.eval_columns(columns, std::span{out}.first(num_points));
+            sink = out[0];
+        });
+    }
+
+    // One animation frame: a parameter changes, then the formula is sampled. Without parameters the frame has to
+    // reparse the formula with the new value substituted.
+    {
+        const std::string_view names[]{"a", "t"};
+        ParameterizedFunction animated{"sin(x * a + t) * exp(-t * t) + cos(a * t) * y / (1 + a * a)", names};
+        const auto t = animated.parameter("t");
+        animated.set(animated.parameter("a"), 1.5);
+
+        double time = 0.;
+        runner.run("animate/reparse", num_points, [&] {
+            time += 0.01;
+            const auto value    = std::to_string(time);
+            const auto function = ShuntingYardAlgorithm::parse_text_input(
+                "sin(x * 1.5 + " + value + ") * exp(-" + value + " * " + value + ") + cos(1.5 * " + value
+                + ") * y / (1 + 1.5 * 1.5)");
+            function.eval_batch(xs, ys, std::span{out}.first(num_points));
+            sink = out[0];
+        });
+        runner.run("animate/parameterized", num_points, [&] {
+            time += 0.01;
+            animated.set(t, time);
+            animated.eval_batch(xs, ys, std::span{out}.first(num_points));
+            sink = out[0];
+        });
+    }
+
+    if (options.output.empty()) {
+        runner.report(std::cout);
+    } else {
+        std::ofstream file{options.output};
+        runner.report(file);
+    }
+    return 0;
+}
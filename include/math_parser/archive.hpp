@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "math_parser.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // On-disk layout of an expression archive, in the byte order of the machine that wrote it:
+        //
+        //     ArchiveHeader
+        //     ArchiveEntry[count]
+        //     source texts, back to back
+        //     per expression, aligned to 16 bytes: Instruction[code_length]
+        //
+        // Instructions are stored exactly as they are in memory, constants inline, so a mapped archive is
+        // evaluated in place through a ProgramView. The version changes whenever the Instruction layout or the
+        // opcode numbering does.
+        struct ArchiveHeader {
+            static constexpr std::array<char, 8> expected_magic{'M', 'P', 'A', 'R', 'C', 'H', 'I', 'V'};
+            static constexpr uint32_t current_version   = 5u;
+            static constexpr uint32_t native_byte_order = 0x01020304u;
+
+            std::array<char, 8> magic{expected_magic};
+            uint32_t version{current_version};
+            uint32_t byte_order{native_byte_order};
+            uint64_t count{0u};
+        };
+
+        struct ArchiveEntry {
+            uint64_t code_offset{0u}; // From the start of the file.
+            uint64_t source_offset{0u};
+            uint32_t code_length{0u}; // In instructions.
+            uint32_t source_length{0u};
+            uint32_t stack_size{0u};
+            uint32_t num_slots{0u};
+            Precision precision{Precision::Double};
+            uint32_t num_variables{0u};
+            Accuracy accuracy{Accuracy::Exact};
+            uint32_t reserved{0u};
+        };
+
+        static_assert(std::is_trivially_copyable_v<Instruction> && sizeof(Instruction) == 16u,
+                      "Archives store instructions verbatim.");
+        static_assert(sizeof(ArchiveHeader) == 24u && sizeof(ArchiveEntry) == 48u);
+
+        // Collects compiled expressions and writes them as one archive.
+        class ArchiveWriter {
+          public:
+            // `source` is stored alongside, so readers can tell the expressions apart. Fused programs, which have
+            // several outputs, and programs over more than two named variables cannot be stored and throw
+            // InvalidArchiveException.
+            void add(std::string_view source, const ParsedFunction &function);
+            void add(std::string_view source, const Program &program);
+
+            void write(std::ostream &out) const;
+            void write(const std::filesystem::path &path) const;
+
+          private:
+            std::vector<std::string> sources;
+            std::vector<Program> programs;
+        };
+
+        // Read-only view of an archive file, memory-mapped where the platform allows it. Nothing is copied or
+        // allocated per expression: every program is evaluated straight from the mapping. Opening checks the
+        // header and that every program is well formed, so evaluation cannot read out of bounds; this touches
+        // each program once, about one page fault apiece for typical expressions.
+        class MappedArchive {
+          public:
+            explicit MappedArchive(const std::filesystem::path &path);
+            ~MappedArchive();
+
+            MappedArchive(MappedArchive &&other) noexcept;
+            MappedArchive &operator=(MappedArchive &&other) noexcept;
+            MappedArchive(const MappedArchive &)            = delete;
+            MappedArchive &operator=(const MappedArchive &) = delete;
+
+            std::size_t size() const { return entries.size(); }
+            std::string_view source(std::size_t i) const;
+            ProgramView program(std::size_t i) const;
+
+            double eval(std::size_t i, double x, double y) const { return execute(program(i), x, y); }
+            void eval_batch(std::size_t i,
+                            std::span<const double> xs,
+                            std::span<const double> ys,
+                            std::span<double> out) const {
+                execute_batch(program(i), xs, ys, out);
+            }
+
+          private:
+            // Checks the whole file and returns its index.
+            std::span<const ArchiveEntry> validate() const;
+            void release();
+
+          private:
+            const std::byte *data = nullptr;
+            std::size_t length    = 0u;
+            bool mapped           = false; // Otherwise `data` was allocated with new[].
+            std::span<const ArchiveEntry> entries;
+        };
+    } // namespace _Internal
+
+    inline namespace V2 {
+        using _Internal::ArchiveWriter;
+        using _Internal::MappedArchive;
+    } // namespace V2
+} // namespace InputHandling
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdexcept>
+
+namespace InputHandling {
+    namespace Exception {
+        struct MismatchedParenthesis : public std::runtime_error {
+          public:
+            MismatchedParenthesis() : std::runtime_error{"You have mismatched parenthesis."} {}
+        };
+
+        struct UnrecognizedSymbolException : public std::runtime_error {
+          public:
+            UnrecognizedSymbolException() : std::runtime_error{"Unrecognized symbol is in the equation."} {}
+        };
+
+        struct TooManyOperatorsException : public std::runtime_error {
+          public:
+            TooManyOperatorsException() : std::runtime_error{"You have too many operators."} {}
+        };
+
+        struct IncorrectNumberOfArgumentsException : public std::runtime_error {
+          public:
+            IncorrectNumberOfArgumentsException() : std::runtime_error{"Incorrect number of arguments."} {}
+        };
+
+        struct InvalidArchiveException : public std::runtime_error {
+          public:
+            InvalidArchiveException() : std::runtime_error{"The expression archive is corrupt or incompatible."} {}
+        };
+    } // namespace Exception
+} // namespace InputHandling
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "math_parser.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Bounded LRU cache of compiled expressions, keyed by the source text with the whitespace that does not
+        // separate tokens removed (see normalize), so that formulas differing only in spacing share an entry. It is
+        // split into independently locked shards so that concurrent lookups of different formulas rarely contend.
+        // Cached functions are immutable and may be shared freely between threads.
+        class ExpressionCache {
+          public:
+            struct Statistics {
+                std::size_t hits{0u};
+                std::size_t misses{0u};
+                std::size_t evictions{0u};
+                std::size_t entries{0u};
+                std::size_t memory_usage{0u}; // Bytes, as estimated by ParsedFunction::memory_usage.
+            };
+
+            explicit ExpressionCache(std::size_t memory_limit = std::size_t{64u} << 20u, std::size_t num_shards = 16u);
+
+            // Returns the compiled form of `expression`, parsing it on a miss. Parse errors are rethrown and the
+            // expression is not cached.
+            std::shared_ptr<const ParsedFunction> get(std::string_view expression);
+
+            Statistics statistics() const;
+            void clear();
+
+            // "1 + 2" and "1+2" have the same key; "1 2", a parse error, keeps its space and differs from "12".
+            static std::string normalize(std::string_view expression);
+
+          private:
+            struct Entry {
+                std::string key;
+                std::shared_ptr<const ParsedFunction> function;
+                std::size_t size;
+            };
+
+            struct Shard {
+                std::mutex mutex;
+                std::list<Entry> lru; // Most recently used first.
+                std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+                std::size_t memory_usage{0u};
+            };
+
+            Shard &shard_of(std::string_view key);
+
+          private:
+            std::vector<std::unique_ptr<Shard>> shards;
+            std::size_t shard_memory_limit;
+
+            std::atomic<std::size_t> hits{0u};
+            std::atomic<std::size_t> misses{0u};
+            std::atomic<std::size_t> evictions{0u};
+        };
+    } // namespace _Internal
+
+    inline namespace V2 {
+        using _Internal::ExpressionCache;
+    } // namespace V2
+} // namespace InputHandling
@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "program.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        struct ExpressionNode {
+            OpCode op;
+            double value{0.}; // Only meaningful for OpCode::Constant.
+            std::array<uint32_t, 3> args{};
+            uint32_t input{0u}; // Only meaningful for OpCode::Variable.
+        };
+
+        struct ExpressionNodeHash {
+            std::size_t operator()(const ExpressionNode &node) const;
+        };
+        struct ExpressionNodeEqual {
+            bool operator()(const ExpressionNode &a, const ExpressionNode &b) const;
+        };
+
+        // Expression as explicit nodes, which is the form the compile-time passes rewrite. Nodes are stored in
+        // topological order: the arguments of a node always precede it. Nodes added through intern() are
+        // hash-consed, so structurally identical subexpressions become one shared node and the graph is a DAG.
+        // The graph and its scratch space are allocated from `resource`, typically an arena released after the pass.
+        struct ExpressionGraph {
+            explicit ExpressionGraph(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+                : nodes{resource}, interned{resource} {}
+
+            std::pmr::vector<ExpressionNode> nodes;
+            uint32_t root{0u};
+
+            uint32_t add(const ExpressionNode &node);
+            uint32_t intern(const ExpressionNode &node);
+
+            static ExpressionGraph from_program(std::span<const Instruction> code,
+                                                std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+            // Adds the expression `code` computes through intern(), so it shares every node the graph already has,
+            // and returns its root.
+            uint32_t merge(std::span<const Instruction> code);
+
+            // Shared nodes are evaluated once: their first occurrence is followed by a Store and every later one
+            // becomes a Load of that slot. The program is allocated from `resource`.
+            Program to_program(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+            // The same for the subexpression rooted at `node`.
+            Program to_subprogram(uint32_t node,
+                                  std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+            // One program computing every root in turn, each popped into the output of the same index. Nodes shared
+            // between roots are computed once as well.
+            Program to_fused_program(std::span<const uint32_t> roots,
+                                     std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+          private:
+            Program lower(std::span<const uint32_t> roots, bool fused, std::pmr::memory_resource *resource) const;
+
+          private:
+            std::pmr::unordered_map<ExpressionNode, uint32_t, ExpressionNodeHash, ExpressionNodeEqual> interned;
+        };
+
+        struct OptimizationStats {
+            std::size_t nodes_before{0u};
+            std::size_t nodes_after{0u};
+
+            std::size_t nodes_eliminated() const { return nodes_before - nodes_after; }
+        };
+
+        // Folds constant subexpressions and applies algebraic identities which leave the result unchanged, signed zeros
+        // included: x*1, x/1, x^1, x-(+0), x+(-0) and double negation. Fast programs also drop x+0 and x-0 and take 0-x
+        // as a negation, which may change the sign of a zero result. Powers with small constant exponents, division by
+        // constants and the reciprocal functions are reduced to cheaper operations, within the tolerances listed in
+        // optimizer.cpp. Exact programs only get x^0, division by a power of two, which keep every value, and x^2 and
+        // x^-1, which become correctly rounded and may differ from pow by 1 ulp. Identical subexpressions are merged
+        // and computed only once per evaluation. The intermediate graphs are allocated from `scratch`; the rewritten
+        // program stays in the memory resource of `program.code`.
+        OptimizationStats optimize(Program &program,
+                                   std::pmr::memory_resource *scratch = std::pmr::get_default_resource());
+    } // namespace _Internal
+} // namespace InputHandling
@@ -0,0 +1,251 @@
+#pragma once
+#include <cfloat>
+#include <cmath>
+#include <type_traits>
+
+#include "simd.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Approximations of the transcendental functions for Accuracy::Fast: range reduction and a polynomial,
+        // written once against the Simd operations so that the same code runs on a double and on a whole pack and
+        // both round identically. Each function has a domain; outside of it (and for NaN) the exact libm function is
+        // used instead, so every result is finite where libm's is and special values are unchanged.
+        //
+        // Largest error against the exact result found by sweeping the domain of each function:
+        //
+        //     function            domain                      max error
+        //     exp                 [-708, 709]                 1 ulp
+        //     ln                  positive normal numbers     1.5 ulp
+        //     log                 positive normal numbers     2 ulp
+        //     sin, cos            |x| <= 2^16                 2.5 ulp
+        //     tan, cot            |x| <= 2^16                 4 ulp
+        //     sec, csc            |x| <= 2^16                 3.5 ulp
+        //     sinh, cosh          |x| <= 708                  2 ulp
+        //     tanh                all numbers                 3 ulp
+        //     sech                |x| <= 708                  2.5 ulp
+        //     csch                |x| <= 708                  3 ulp
+        //     coth                all numbers                 3.5 ulp
+        //
+        // Single-precision programs evaluate the same double approximations and round the result to float, which
+        // keeps them within 1 ulp of the exact float result. pow and the inverse functions always use libm.
+        namespace FastMath {
+            template <typename P> inline P splat(double v) {
+                if constexpr (std::is_same_v<P, double>) {
+                    return v;
+                } else {
+                    return Simd::broadcast(v);
+                }
+            }
+
+            // Polynomial with coefficients from the highest degree down, as two Horner chains in x^2, over the even
+            // and the odd powers, which run side by side in half the latency of one.
+            template <typename P, std::size_t N> inline P polynomial(P x, const double (&coefficients)[N]) {
+                static_assert(N >= 2u);
+
+                const P x2 = Simd::mul(x, x);
+                P high     = splat<P>(coefficients[0]); // Degree N - 1, N - 3, ...
+                P low      = splat<P>(coefficients[1]); // Degree N - 2, N - 4, ...
+                for (std::size_t i = 2u; i + 1u < N; i += 2u) {
+                    high = Simd::add(Simd::mul(high, x2), splat<P>(coefficients[i]));
+                    low  = Simd::add(Simd::mul(low, x2), splat<P>(coefficients[i + 1u]));
+                }
+                if constexpr (N % 2u == 1u) {
+                    high = Simd::add(Simd::mul(high, x2), splat<P>(coefficients[N - 1u]));
+                    return Simd::add(high, Simd::mul(x, low));
+                } else {
+                    return Simd::add(low, Simd::mul(x, high));
+                }
+            }
+
+            // v rounded to the nearest integer, for |v| < 2^51: adding 1.5 * 2^52 leaves no fraction bits.
+            template <typename P> inline P nearest(P v) {
+                const P magic = splat<P>(0x1.8p52);
+                return Simd::sub(Simd::add(v, magic), magic);
+            }
+
+            // ln 2 split so that k * ln2_hi is exact for every exponent k.
+            constexpr double ln2_hi = 6.93147180369123816490e-01;
+            constexpr double ln2_lo = 1.90821492927058770002e-10;
+
+            // x = k ln 2 + r with |r| <= ln 2 / 2, then e^r = 1 + r + r^2 q(r) from its Taylor series and
+            // e^x = 2^k e^r. The leading terms are added last, smallest first.
+            template <typename P> inline P exp(P x) {
+                static constexpr double taylor[]{1. / 6227020800., 1. / 479001600., 1. / 39916800., 1. / 3628800.,
+                                                 1. / 362880.,     1. / 40320.,     1. / 5040.,     1. / 720.,
+                                                 1. / 120.,        1. / 24.,        1. / 6.,        1. / 2.};
+
+                const P k  = nearest(Simd::mul(x, splat<P>(1.44269504088896338700e+00)));
+                const P r  = Simd::sub(Simd::sub(x, Simd::mul(k, splat<P>(ln2_hi))), Simd::mul(k, splat<P>(ln2_lo)));
+                const P er = Simd::add(splat<P>(1.), Simd::add(r, Simd::mul(Simd::mul(r, r), polynomial(r, taylor))));
+                return Simd::scale(er, k);
+            }
+
+            // x = 2^e m with m in [sqrt(2)/2, sqrt(2)). Returns ln m, which the callers combine with e, following
+            // fdlibm's log: with f = m - 1 and s = f / (2 + f), ln m = f - f^2/2 + s (f^2/2 + R(s^2)).
+            template <typename P> inline P log_significand(P x, P &e) {
+                static constexpr double odd[]{1.479819860511658591e-01, 1.818357216161805012e-01,
+                                              2.857142874366239149e-01, 6.666666666666735130e-01};
+                static constexpr double even[]{1.531383769920937332e-01, 2.222219843214978396e-01,
+                                               3.999999999940941908e-01};
+
+                const P one  = splat<P>(1.);
+                const P half = splat<P>(0.5);
+                P m          = Simd::significand(x);
+                const P high = Simd::select_less(splat<P>(1.41421356237309504880), m, one, splat<P>(0.));
+                m            = Simd::select_less(splat<P>(1.41421356237309504880), m, Simd::mul(m, half), m);
+                e            = Simd::add(Simd::exponent(x), high);
+
+                const P f    = Simd::sub(m, one);
+                const P hfsq = Simd::mul(Simd::mul(half, f), f);
+                const P s    = Simd::div(f, Simd::add(splat<P>(2.), f));
+                const P z    = Simd::mul(s, s);
+                const P w    = Simd::mul(z, z);
+                const P R    = Simd::add(Simd::mul(z, polynomial(w, odd)), Simd::mul(w, polynomial(w, even)));
+                return Simd::sub(f, Simd::sub(hfsq, Simd::mul(s, Simd::add(hfsq, R))));
+            }
+
+            template <typename P> inline P log(P x) {
+                P e;
+                const P lm = log_significand(x, e);
+                return Simd::add(Simd::mul(e, splat<P>(ln2_hi)), Simd::add(Simd::mul(e, splat<P>(ln2_lo)), lm));
+            }
+
+            template <typename P> inline P log10(P x) {
+                P e;
+                const P lm = log_significand(x, e);
+                const P lo = Simd::add(Simd::mul(e, splat<P>(3.69423907715893078616e-13)),
+                                       Simd::mul(lm, splat<P>(4.34294481903251816668e-01)));
+                return Simd::add(Simd::mul(e, splat<P>(3.01029995663611771306e-01)), lo);
+            }
+
+            // x = k pi/2 + r with |r| <= pi/4 for x >= 0, pi/2 split in three parts of which the first two multiply
+            // exactly. sin r and cos r come from fdlibm's kernels. `odd` is k mod 2 and `upper` whether k mod 4 is 2
+            // or 3, both as 0 or 1.
+            template <typename P> inline void sin_cos(P x, P &sin_r, P &cos_r, P &odd, P &upper) {
+                static constexpr double sin_terms[]{1.58969099521155010221e-10, -2.50507602534068634195e-08,
+                                                    2.75573137070700676789e-06, -1.98412698298579493134e-04,
+                                                    8.33333333332248946124e-03, -1.66666666666666324348e-01};
+                static constexpr double cos_terms[]{-1.13596475577881948265e-11, 2.08757232129817482790e-09,
+                                                    -2.75573143513906633035e-07, 2.48015872894767294178e-05,
+                                                    -1.38888888888741095749e-03, 4.16666666666666019037e-02};
+
+                const P k = nearest(Simd::mul(x, splat<P>(6.36619772367581382433e-01)));
+                P r       = Simd::sub(x, Simd::mul(k, splat<P>(1.57079632673412561417e+00)));
+                r         = Simd::sub(r, Simd::mul(k, splat<P>(6.07710050630396597660e-11)));
+                r         = Simd::sub(r, Simd::mul(k, splat<P>(2.02226624879595063154e-21)));
+
+                // floor(k / 2), by rounding k / 2 - 1/4 to nearest; likewise for half of that.
+                const P half    = nearest(Simd::sub(Simd::mul(k, splat<P>(0.5)), splat<P>(0.25)));
+                const P quarter = nearest(Simd::sub(Simd::mul(half, splat<P>(0.5)), splat<P>(0.25)));
+                odd             = Simd::sub(k, Simd::add(half, half));
+                upper           = Simd::sub(half, Simd::add(quarter, quarter));
+
+                const P z  = Simd::mul(r, r);
+                sin_r      = Simd::add(r, Simd::mul(Simd::mul(z, r), polynomial(z, sin_terms)));
+                const P hz = Simd::mul(splat<P>(0.5), z);
+                const P w  = Simd::sub(splat<P>(1.), hz);
+                const P c  = Simd::mul(Simd::mul(z, z), polynomial(z, cos_terms));
+                cos_r      = Simd::add(w, Simd::add(Simd::sub(Simd::sub(splat<P>(1.), w), hz), c));
+            }
+
+            // All are computed for |x|; the odd functions then take the sign of x, which keeps the sign of zero.
+            template <typename P> inline P sin(P x) {
+                P s, c, odd, upper;
+                sin_cos(Simd::abs(x), s, c, odd, upper);
+                const P v = Simd::select_less(odd, splat<P>(0.5), s, c);
+                return Simd::flip_sign(Simd::select_less(upper, splat<P>(0.5), v, Simd::neg(v)), x);
+            }
+
+            template <typename P> inline P cos(P x) {
+                P s, c, odd, upper;
+                sin_cos(Simd::abs(x), s, c, odd, upper);
+                const P v = Simd::select_less(odd, splat<P>(0.5), c, s);
+                // Negative when k mod 4 is 1 or 2.
+                const P negative = Simd::abs(Simd::sub(odd, upper));
+                return Simd::select_less(negative, splat<P>(0.5), v, Simd::neg(v));
+            }
+
+            // tan x = s / c for even k and -c / s for odd k; cot x the other way round.
+            template <typename P> inline P tangent(P x, bool cotangent) {
+                P s, c, odd, upper;
+                sin_cos(Simd::abs(x), s, c, odd, upper);
+                const P top    = cotangent ? c : s;
+                const P bottom = cotangent ? s : c;
+                const P v      = Simd::div(Simd::select_less(odd, splat<P>(0.5), top, bottom),
+                                      Simd::select_less(odd, splat<P>(0.5), bottom, top));
+                return Simd::flip_sign(Simd::select_less(odd, splat<P>(0.5), v, Simd::neg(v)), x);
+            }
+
+            template <typename P> inline P tan(P x) { return tangent(x, false); }
+            template <typename P> inline P cot(P x) { return tangent(x, true); }
+
+            // Taylor series of sinh, for |x| < 1.
+            template <typename P> inline P sinh_series(P x) {
+                static constexpr double taylor[]{1. / 121645100408832000., 1. / 355687428096000., 1. / 1307674368000.,
+                                                 1. / 6227020800.,         1. / 39916800.,        1. / 362880.,
+                                                 1. / 5040.,               1. / 120.,             1. / 6.};
+
+                const P z = Simd::mul(x, x);
+                return Simd::add(x, Simd::mul(Simd::mul(x, z), polynomial(z, taylor)));
+            }
+
+            template <typename P> inline P sinh(P x) {
+                const P a     = Simd::abs(x);
+                const P e     = exp(a);
+                const P large = Simd::sub(Simd::mul(splat<P>(0.5), e), Simd::div(splat<P>(0.5), e));
+                return Simd::flip_sign(Simd::select_less(a, splat<P>(1.), sinh_series(a), large), x);
+            }
+
+            template <typename P> inline P cosh(P x) {
+                const P e = exp(Simd::abs(x));
+                return Simd::add(Simd::mul(splat<P>(0.5), e), Simd::div(splat<P>(0.5), e));
+            }
+
+            // s / c near zero, 1 - 2 / (e^2|x| + 1) further out, where it no longer cancels. Beyond 20 the result
+            // rounds to 1 anyway, which also keeps e^2|x| finite.
+            template <typename P> inline P tanh(P x) {
+                const P a     = Simd::lesser_of(Simd::abs(x), splat<P>(20.));
+                const P e     = exp(a);
+                const P cosh  = Simd::add(Simd::mul(splat<P>(0.5), e), Simd::div(splat<P>(0.5), e));
+                const P small = Simd::div(sinh_series(a), cosh);
+                const P large =
+                    Simd::sub(splat<P>(1.), Simd::div(splat<P>(2.), Simd::add(Simd::mul(e, e), splat<P>(1.))));
+                return Simd::flip_sign(Simd::select_less(a, splat<P>(0.625), small, large), x);
+            }
+
+            constexpr double trig_limit = 65536.;
+
+            // One function each: its domain, its approximation over double or a pack, and the exact function.
+#define MATH_PARSER_FAST_FUNCTION(Name, domain, approximation, exact_function)                                         \
+    struct Name {                                                                                                      \
+        static bool in_domain(double v) { return domain; }                                                             \
+        template <typename P> static P approximate(P x) { return approximation; }                                     \
+        static double exact(double v) { return exact_function; }                                                       \
+    };
+
+            MATH_PARSER_FAST_FUNCTION(Exp, v >= -708. && v <= 709., exp(x), std::exp(v))
+            MATH_PARSER_FAST_FUNCTION(Ln, v >= DBL_MIN && v <= DBL_MAX, log(x), std::log(v))
+            MATH_PARSER_FAST_FUNCTION(Log, v >= DBL_MIN && v <= DBL_MAX, log10(x), std::log10(v))
+            MATH_PARSER_FAST_FUNCTION(Sin, std::abs(v) <= trig_limit, sin(x), std::sin(v))
+            MATH_PARSER_FAST_FUNCTION(Cos, std::abs(v) <= trig_limit, cos(x), std::cos(v))
+            MATH_PARSER_FAST_FUNCTION(Tan, std::abs(v) <= trig_limit, tan(x), std::tan(v))
+            MATH_PARSER_FAST_FUNCTION(Sec, std::abs(v) <= trig_limit, Simd::div(splat<P>(1.), cos(x)), 1. / std::cos(v))
+            MATH_PARSER_FAST_FUNCTION(Csc, std::abs(v) <= trig_limit, Simd::div(splat<P>(1.), sin(x)), 1. / std::sin(v))
+            MATH_PARSER_FAST_FUNCTION(Cot, std::abs(v) <= trig_limit, cot(x), 1. / std::tan(v))
+            MATH_PARSER_FAST_FUNCTION(Sinh, std::abs(v) <= 708., sinh(x), std::sinh(v))
+            MATH_PARSER_FAST_FUNCTION(Cosh, std::abs(v) <= 708., cosh(x), std::cosh(v))
+            MATH_PARSER_FAST_FUNCTION(Tanh, v == v, tanh(x), std::tanh(v))
+            MATH_PARSER_FAST_FUNCTION(Sech, std::abs(v) <= 708., Simd::div(splat<P>(1.), cosh(x)), 1. / std::cosh(v))
+            MATH_PARSER_FAST_FUNCTION(Csch, std::abs(v) <= 708., Simd::div(splat<P>(1.), sinh(x)), 1. / std::sinh(v))
+            MATH_PARSER_FAST_FUNCTION(Coth, v == v, Simd::div(splat<P>(1.), tanh(x)), 1. / std::tanh(v))
+#undef MATH_PARSER_FAST_FUNCTION
+
+            // Per-point evaluation, in double whatever T is.
+            template <typename F, typename T> inline T evaluate(T v) {
+                const double d = v;
+                return static_cast<T>(F::in_domain(d) ? F::approximate(d) : F::exact(d));
+            }
+        } // namespace FastMath
+    }     // namespace _Internal
+} // namespace InputHandling
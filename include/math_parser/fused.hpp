@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+#include "math_parser.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Several functions of the same x and y compiled into one program. Subexpressions shared between any of
+        // them are computed once per point, the inputs are read once per block and every result is written in the
+        // same sweep, which pays off when many related formulas are sampled over one set of points.
+        //
+        //     std::vector<ParsedFunction> functions{parse("sin(x)*y"), parse("sin(x)*y + 1"), parse("cos(x)")};
+        //     FusedFunction fused{functions};
+        //     fused.eval_batch(xs, ys, std::array{std::span{a}, std::span{b}, std::span{c}});
+        //
+        // Results equal those of every function on its own. All functions must have the same precision and accuracy.
+        class FusedFunction {
+          public:
+            explicit FusedFunction(std::span<const ParsedFunction> functions);
+
+            // Number of functions, and of outputs every evaluation writes.
+            std::size_t size() const { return compiled.num_outputs; }
+
+            // out[k] receives function k at (x, y).
+            void eval(double x, double y, std::span<double> out) const;
+            void eval(float x, float y, std::span<float> out) const;
+            // outs[k][i] receives function k at (xs[i], ys[i]). Every span must have the same length.
+            void eval_batch(std::span<const double> xs,
+                            std::span<const double> ys,
+                            std::span<const std::span<double>> outs) const;
+            void eval_batch(std::span<const float> xs,
+                            std::span<const float> ys,
+                            std::span<const std::span<float>> outs) const;
+
+            const Program &program() const { return compiled; }
+            // `nodes_before` counts the nodes of all functions compiled separately.
+            const OptimizationStats &optimization_stats() const { return stats; }
+
+          private:
+            Program compiled;
+            OptimizationStats stats;
+        };
+    } // namespace _Internal
+
+    inline namespace V2 {
+        using _Internal::FusedFunction;
+    } // namespace V2
+} // namespace InputHandling
@@ -0,0 +1,28 @@
+#pragma once
+#include <span>
+
+#include "program.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Value of an expression together with its partial derivatives.
+        struct Gradient {
+            double value{0.};
+            double dx{0.}; // Partial derivative with respect to x.
+            double dy{0.}; // Partial derivative with respect to y.
+        };
+
+        // Forward-mode automatic differentiation: every stack entry carries its partial derivatives, so one pass
+        // over the program yields the value and the exact gradient. Everything is computed in double with libm: for a
+        // double-precision program of exact accuracy, `value` has the same bits execute() returns; for a
+        // single-precision or fast one it is the more accurate value and may differ from execute() in the last bits.
+        // Where a function is not differentiable (the jump of step, the kinks of abs, min or clamp) the one-sided
+        // derivative of the branch the value came from is used; piecewise constant functions have derivative 0.
+        Gradient execute_with_gradient(const ProgramView &program, double x, double y);
+
+        void execute_batch_with_gradient(const ProgramView &program,
+                                         std::span<const double> xs,
+                                         std::span<const double> ys,
+                                         std::span<Gradient> out);
+    } // namespace _Internal
+} // namespace InputHandling
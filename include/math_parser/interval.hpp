@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "program.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Closed interval [lo, hi]. Infinite bounds are allowed; lo > hi (or a NaN bound) denotes the empty set.
+        struct Interval {
+            double lo{0.};
+            double hi{0.};
+
+            static constexpr Interval empty() {
+                return {std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+            }
+            static constexpr Interval entire() {
+                return {-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+            }
+
+            constexpr bool is_empty() const { return (lo <= hi) == false; }
+            constexpr bool contains(double v) const { return lo <= v && v <= hi; }
+        };
+
+        // Axis-aligned rectangle of the plane.
+        struct Box {
+            Interval x;
+            Interval y;
+        };
+
+        // Sound enclosure of the expression over the box x × y: every value it takes at a point of the box where it
+        // is defined lies in the result. Bounds are rounded outward, one ulp for arithmetic and four for library
+        // functions, which is more than the documented error of glibc's. Points outside a function's domain
+        // contribute nothing, so a box where the expression is undefined everywhere yields the empty interval.
+        Interval execute_interval(const ProgramView &program, Interval x, Interval y);
+
+        // Quadtree search for the zero set of the expression, as needed to plot the implicit curve f(x, y) = 0.
+        // Boxes whose enclosure excludes zero are discarded, the others are split into quarters until they are
+        // `max_depth` levels below `region`. Returns those leaves: together they cover every zero in the region.
+        std::vector<Box> implicit_curve_cells(const ProgramView &program, const Box &region, uint32_t max_depth);
+    } // namespace _Internal
+} // namespace InputHandling
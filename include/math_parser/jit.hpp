@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+#include "math_parser.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Native x86-64 code for a compiled expression. Arithmetic, negation, min and max are emitted as SSE2
+        // instructions, packed two points at a time in the batch entry; every other function is a direct call
+        // into the same kernels the interpreter runs, once per point, so all of them agree bit for bit. Where no
+        // JIT is available (other architectures or ABIs, or when executable memory cannot be mapped) the object
+        // falls back to interpreting the program, as it does for functions compiled at single precision or over
+        // named variables.
+        class JitFunction {
+          public:
+            using ScalarEntry = double (*)(double x, double y);
+            using BatchEntry  = void (*)(const double *xs, const double *ys, double *out, std::size_t n);
+
+            explicit JitFunction(const ParsedFunction &function);
+            ~JitFunction();
+
+            JitFunction(JitFunction &&other) noexcept;
+            JitFunction &operator=(JitFunction &&other) noexcept;
+            JitFunction(const JitFunction &)            = delete;
+            JitFunction &operator=(const JitFunction &) = delete;
+
+            bool is_native() const { return scalar_entry != nullptr; }
+            // Entry points into the generated code, or nullptr when running on the interpreter. They stay valid
+            // for the lifetime of this object.
+            ScalarEntry native() const { return scalar_entry; }
+            BatchEntry native_batch() const { return batch_entry; }
+
+            double eval(double x, double y) const;
+            void eval_batch(std::span<const double> xs, std::span<const double> ys, std::span<double> out) const;
+
+          private:
+            void release();
+
+          private:
+            Program program;
+
+            void *code            = nullptr;
+            std::size_t code_size = 0u;
+            ScalarEntry scalar_entry{nullptr};
+            BatchEntry batch_entry{nullptr};
+        };
+    } // namespace _Internal
+
+    inline namespace V2 {
+        using _Internal::JitFunction;
+    } // namespace V2
+} // namespace InputHandling
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace InputHandling {
+    namespace _Internal {
+        // Scalar definitions of every function the grammar exposes, for double and float. They are shared by all
+        // evaluation back ends, so any two ways of evaluating the same expression agree on the result.
+        namespace Kernels {
+            template <typename T> inline T sec(T v) { return T(1) / std::cos(v); }
+            template <typename T> inline T csc(T v) { return T(1) / std::sin(v); }
+            template <typename T> inline T cot(T v) { return T(1) / std::tan(v); }
+            template <typename T> inline T sech(T v) { return T(1) / std::cosh(v); }
+            template <typename T> inline T csch(T v) { return T(1) / std::sinh(v); }
+            template <typename T> inline T coth(T v) { return T(1) / std::tanh(v); }
+
+            template <typename T> inline T sign(T v) { return static_cast<T>((v > T(0)) - (v < T(0))); }
+            template <typename T> inline T fract(T v) {
+                T whole;
+                return std::modf(v, &whole);
+            }
+
+            template <typename T> inline T max(T a, T b) { return std::max(a, b); }
+            template <typename T> inline T min(T a, T b) { return std::min(a, b); }
+            template <typename T> inline T step(T edge, T v) { return v < edge ? T(0) : T(1); }
+
+            template <typename T> inline T clamp(T v, T lo, T hi) { return std::clamp(v, lo, hi); }
+            template <typename T> inline T mix(T a, T b, T t) { return a * (T(1) - t) + b * t; }
+            template <typename T> inline T smoothstep(T e1, T e2, T v) {
+                const T t = std::clamp((v - e1) / (e2 - e1), T(0), T(1));
+                return t * t * (T(3) - T(2) * t);
+            }
+
+            template <typename T> inline T square(T v) { return v * v; }
+            template <typename T> inline T sqrt(T v) {
+                return v == -std::numeric_limits<T>::infinity() ? -v : std::sqrt(v) + T(0);
+            }
+            template <typename T> inline T mul_add(T a, T b, T c) { return std::fma(a, b, c); }
+        } // namespace Kernels
+    }     // namespace _Internal
+} // namespace InputHandling
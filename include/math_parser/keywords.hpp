@@ -0,0 +1,145 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "tokens.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        constexpr std::size_t num_functions = static_cast<std::size_t>(Function::Smoothstep) + 1u;
+        constexpr std::size_t num_operators = static_cast<std::size_t>(Operator::Neg) + 1u;
+
+        constexpr uint32_t function_arity(Function f) {
+            switch (f) {
+            case Function::Max:
+            case Function::Min:
+            case Function::Step: return 2u;
+            case Function::Clamp:
+            case Function::Mix:
+            case Function::Smoothstep: return 3u;
+            default: return 1u;
+            }
+        }
+
+        // Immutable token table. The lexer hands out pointers into it, so tokens are never allocated or copied.
+        inline constexpr auto function_tokens = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array{FunctionToken{static_cast<Function>(I), function_arity(static_cast<Function>(I))}...};
+        }(std::make_index_sequence<num_functions>{});
+
+        inline constexpr auto operator_tokens = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array{OperatorToken{static_cast<Operator>(I)}...};
+        }(std::make_index_sequence<num_operators>{});
+
+        inline constexpr OperandToken x_token{Operand::X};
+        inline constexpr OperandToken y_token{Operand::Y};
+        inline constexpr OperandToken number_token{Operand::Number};
+        inline constexpr OperandToken variable_token{Operand::Variable};
+
+        constexpr const Token *token_of(Function f) { return &function_tokens[static_cast<std::size_t>(f)]; }
+        constexpr const Token *token_of(Operator o) { return &operator_tokens[static_cast<std::size_t>(o)]; }
+
+        struct Keyword {
+            std::string_view text;
+            const Token *token;
+        };
+
+        inline constexpr std::array keywords{
+            Keyword{"x", &x_token},
+            Keyword{"y", &y_token},
+
+            Keyword{"sin", token_of(Function::Sin)},
+            Keyword{"cos", token_of(Function::Cos)},
+            Keyword{"tan", token_of(Function::Tan)},
+            Keyword{"sec", token_of(Function::Sec)},
+            Keyword{"csc", token_of(Function::Csc)},
+            Keyword{"cot", token_of(Function::Cot)},
+
+            Keyword{"sinh", token_of(Function::Sinh)},
+            Keyword{"cosh", token_of(Function::Cosh)},
+            Keyword{"tanh", token_of(Function::Tanh)},
+            Keyword{"sech", token_of(Function::Sech)},
+            Keyword{"csch", token_of(Function::Csch)},
+            Keyword{"coth", token_of(Function::Coth)},
+
+            Keyword{"asin", token_of(Function::Asin)},
+            Keyword{"acos", token_of(Function::Acos)},
+            Keyword{"atan", token_of(Function::Atan)},
+
+            Keyword{"asinh", token_of(Function::Asinh)},
+            Keyword{"acosh", token_of(Function::Acosh)},
+            Keyword{"atanh", token_of(Function::Atanh)},
+
+            Keyword{"ln", token_of(Function::Ln)},
+            Keyword{"abs", token_of(Function::Abs)},
+            Keyword{"exp", token_of(Function::Exp)},
+            Keyword{"log", token_of(Function::Log)},
+            Keyword{"sign", token_of(Function::Sign)},
+            Keyword{"floor", token_of(Function::Floor)},
+            Keyword{"ceil", token_of(Function::Ceil)},
+            Keyword{"trunc", token_of(Function::Trunc)},
+            Keyword{"fract", token_of(Function::Fract)},
+
+            Keyword{"max", token_of(Function::Max)},
+            Keyword{"min", token_of(Function::Min)},
+            Keyword{"step", token_of(Function::Step)},
+
+            Keyword{"clamp", token_of(Function::Clamp)},
+            Keyword{"mix", token_of(Function::Mix)},
+            Keyword{"smoothstep", token_of(Function::Smoothstep)},
+        };
+
+        // Trie over the lowercase keywords, built at compile time. Lookup is one array index per character.
+        struct KeywordTrie {
+            struct Node {
+                std::array<uint8_t, 26> children{}; // 0 means no child; the root is never anyone's child.
+                int8_t keyword{-1};                 // Index into `keywords` of the keyword ending at this node.
+            };
+
+            struct Match {
+                const Token *token{nullptr};
+                std::size_t length{0u};
+            };
+
+            // Longest keyword that `text` starts with.
+            constexpr Match longest_match(std::string_view text) const {
+                Match match;
+                std::size_t node = 0u;
+                for (std::size_t i = 0u; i < text.size(); ++i) {
+                    if (text[i] < 'a' || text[i] > 'z') { break; }
+
+                    node = nodes[node].children[text[i] - 'a'];
+                    if (node == 0u) { break; }
+                    if (nodes[node].keyword >= 0) { match = {keywords[nodes[node].keyword].token, i + 1u}; }
+                }
+                return match;
+            }
+
+            std::array<Node, 128> nodes{};
+            std::size_t size{1u};
+        };
+
+        consteval KeywordTrie build_keyword_trie() {
+            KeywordTrie trie;
+            for (std::size_t k = 0u; k < keywords.size(); ++k) {
+                std::size_t node = 0u;
+                for (const char c : keywords[k].text) {
+                    if (c < 'a' || c > 'z') { throw "Keywords must consist of lowercase letters."; }
+
+                    auto &child = trie.nodes[node].children[c - 'a'];
+                    if (child == 0u) {
+                        if (trie.size == trie.nodes.size()) { throw "Keyword trie capacity exceeded."; }
+                        child = static_cast<uint8_t>(trie.size++);
+                    }
+                    node = child;
+                }
+                trie.nodes[node].keyword = static_cast<int8_t>(k);
+            }
+            return trie;
+        }
+
+        inline constexpr KeywordTrie keyword_trie = build_keyword_trie();
+    } // namespace _Internal
+} // namespace InputHandling
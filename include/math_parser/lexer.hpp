@@ -0,0 +1,157 @@
+#pragma once
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include "keywords.hpp"
+#include "tokens.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        struct Lexeme {
+            const Token *token{nullptr}; // Points into the static token table in keywords.hpp.
+            double number{0.};           // Value of a number literal.
+            float single{0.f};           // The same literal rounded to float directly, not through `number`.
+            uint32_t variable{0u};       // Index of a named variable among those declared.
+            std::size_t offset{0u};      // Position of the lexeme in the source text.
+            std::size_t length{0u};
+        };
+
+        constexpr bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+        }
+        constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+        constexpr bool is_identifier_start(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+        constexpr bool is_identifier(char c) { return is_identifier_start(c) || is_digit(c); }
+
+        // Constant-evaluation counterpart of std::from_chars for fixed notation. It only accepts literals whose
+        // significand fits in 53 bits and whose scale is at most 10^22: both are then exact doubles, so the single
+        // division is correctly rounded and agrees with from_chars. Longer literals are rejected rather than
+        // rounded differently from the run-time parser.
+        constexpr double parse_fixed(std::string_view text, std::size_t &cursor) {
+            constexpr uint64_t max_significand = uint64_t{1} << 53u;
+
+            uint64_t significand = 0u;
+            int scale            = 0;
+            bool fraction        = false;
+            for (; cursor < text.size(); ++cursor) {
+                if (text[cursor] == '.' && fraction == false) {
+                    fraction = true;
+                    continue;
+                }
+                if (is_digit(text[cursor]) == false) { break; }
+
+                if (significand > max_significand) {
+                    throw "Number literal has too many digits to be converted exactly at compile time.";
+                }
+                significand = significand * 10u + static_cast<uint64_t>(text[cursor] - '0');
+                scale += fraction ? 1 : 0;
+            }
+            if (significand > max_significand || scale > 22) {
+                throw "Number literal has too many digits to be converted exactly at compile time.";
+            }
+
+            double power = 1.;
+            for (int i = 0; i < scale; ++i) { power *= 10.; }
+            return static_cast<double>(significand) / power;
+        }
+
+        // Single-pass cursor over the source text. It neither copies the text nor allocates per token, and it runs
+        // unchanged during constant evaluation, where lexical errors become compile errors.
+        //
+        // Without declared variables the inputs are x and y. Otherwise every identifier that names one of
+        // `variables` is that variable, x and y are no longer special and the keywords still denote functions.
+        class Lexer {
+          public:
+            constexpr explicit Lexer(std::string_view input, std::span<const std::string_view> variables = {})
+                : input{input}, variables{variables} {}
+
+            // Skips whitespace and reports whether any input is left.
+            constexpr bool done() {
+                while (cursor < input.size() && is_space(input[cursor])) { ++cursor; }
+                return cursor == input.size();
+            }
+
+            // The next lexeme, or one without a token when the text at its offset is no symbol of the grammar. The
+            // cursor then stays where it is.
+            constexpr Lexeme next() {
+                assert(("Input string is empty." && done() == false));
+
+                const auto start = cursor;
+                const char c     = input[cursor];
+
+                if (is_digit(c)) {
+                    double number = 0.;
+                    float single  = 0.f;
+                    if (std::is_constant_evaluated()) {
+                        // parse_fixed is exact before its one rounding, so narrowing it rounds only once as well.
+                        number = parse_fixed(input, cursor);
+                        single = static_cast<float>(number);
+                    } else {
+                        const auto first = input.data() + cursor;
+                        const auto last  = input.data() + input.size();
+
+                        const auto [end, ec] = std::from_chars(first, last, number, std::chars_format::fixed);
+                        if (ec != std::errc{}) { return {.offset = start}; }
+                        // Out of range for float only: the conversion rounds it to infinity, or to 0 or a subnormal.
+                        if (std::from_chars(first, end, single, std::chars_format::fixed).ec != std::errc{}) {
+                            single = static_cast<float>(number);
+                        }
+
+                        cursor = end - input.data();
+                    }
+                    return {&number_token, number, single, 0u, start, cursor - start};
+                }
+
+                const Token *symbol = nullptr;
+                switch (c) {
+                case '(': symbol = token_of(Operator::OpeningParenthesis); break;
+                case ')': symbol = token_of(Operator::ClosingParenthesis); break;
+                case '+': symbol = token_of(Operator::Add); break;
+                case '-': symbol = token_of(Operator::Sub); break;
+                case '*': symbol = token_of(Operator::Mul); break;
+                case '/': symbol = token_of(Operator::Div); break;
+                case '^': symbol = token_of(Operator::Pow); break;
+                case ',': symbol = token_of(Operator::Comma); break;
+                default: break;
+                }
+                if (symbol) {
+                    ++cursor;
+                    return {symbol, 0., 0.f, 0u, start, 1u};
+                }
+
+                if (variables.empty() == false && is_identifier_start(c)) {
+                    auto end = cursor;
+                    while (end < input.size() && is_identifier(input[end])) { ++end; }
+
+                    const auto name = input.substr(cursor, end - cursor);
+                    for (std::size_t v = 0u; v < variables.size(); ++v) {
+                        if (variables[v] == name) {
+                            cursor = end;
+                            return {&variable_token, 0., 0.f, static_cast<uint32_t>(v), start, name.size()};
+                        }
+                    }
+                }
+
+                const auto match = keyword_trie.longest_match(input.substr(cursor));
+                if (match.token == nullptr || (variables.empty() == false && match.token->type == Type::Operand)) {
+                    return {.offset = start};
+                }
+
+                cursor += match.length;
+                return {match.token, 0., 0.f, 0u, start, match.length};
+            }
+
+          private:
+            std::string_view input;
+            std::span<const std::string_view> variables;
+            std::size_t cursor{0u};
+        };
+    } // namespace _Internal
+} // namespace InputHandling
@@ -1,81 +1,168 @@
 #pragma once
 #include <stdexcept>
-#include <memory>
+#include <algorithm>
 #include <optional>
 #include <vector>
-#include <stack>
-#include <queue>
 #include <cassert>
 #include <cmath>
-#include <map>
+#include <memory>
+#include <memory_resource>
 #include <string>
 
+#include "exceptions.hpp"
 #include "tokens.hpp"
+#include "lexer.hpp"
+#include "parse_error.hpp"
+#include "parser.hpp"
+#include "program.hpp"
+#include "gradient.hpp"
+#include "interval.hpp"
+#include "profiler.hpp"
+#include "expression_graph.hpp"
+#include "thread_pool.hpp"
 
 namespace InputHandling {
 
-    namespace Exception {
-        struct MismatchedParenthesis : public std::runtime_error {
-          public:
-            MismatchedParenthesis() : std::runtime_error{"You have mismatched parenthesis."} {}
-        };
-
-        struct UnrecognizedSymbolException : public std::runtime_error {
-          public:
-            UnrecognizedSymbolException() : std::runtime_error{"Unrecognized symbol is in the equation."} {}
-        };
-
-        struct TooManyOperatorsException : public std::runtime_error {
-          public:
-            TooManyOperatorsException() : std::runtime_error{"You have too many operators."} {}
-        };
-
-        struct IncorrectNumberOfArgumentsException : public std::runtime_error {
-          public:
-            IncorrectNumberOfArgumentsException() : std::runtime_error{"Incorrect number of arguments."} {}
-        };
-    } // namespace Exception
-
     namespace _Internal {
-        using PToken = std::shared_ptr<Token>;
-        struct TokenEvaluator;
-        using PTokenEvaluator = std::shared_ptr<TokenEvaluator>;
-
-        constexpr auto to_oprt    = [](PToken pt) { return static_cast<OperatorToken *>(pt.get()); };
-        constexpr auto to_opnd    = [](PToken pt) { return static_cast<OperandToken *>(pt.get()); };
-        constexpr auto to_func    = [](PToken pt) { return static_cast<FunctionToken *>(pt.get()); };
-        constexpr auto is_type_of = [](PToken pt, Type t) -> bool { return pt.get()->type == t; };
-
+        // Immutable once constructed: every eval* member is const and may be called from many threads at once.
+        //
+        // The compiled program is allocated from the memory resource of `allocator`, so many functions can share one
+        // arena (e.g. a std::pmr::monotonic_buffer_resource) which must then outlive them. Copies allocate from the
+        // default resource.
+        //
+        // `precision` selects the arithmetic eval, eval_batch and eval_grid use, whatever the type of their arguments.
+        // Gradients and intervals are always computed in double, from the same constants. `accuracy` selects libm or
+        // the faster approximations of fast_math.hpp for the values; gradients and intervals always use libm.
+        //
+        // A function parsed over named variables takes their values in declaration order, through eval(values) or
+        // eval_columns; the members taking x and y then do not apply.
         struct ParsedFunction {
-            ParsedFunction(std::queue<PToken> tokens);
+            using allocator_type = std::pmr::polymorphic_allocator<>;
+
+            ParsedFunction(std::span<const Lexeme> rpn, const allocator_type &allocator = {});
+            ParsedFunction(std::span<const Lexeme> rpn, Precision precision, const allocator_type &allocator = {});
+            ParsedFunction(std::span<const Lexeme> rpn,
+                           Precision precision,
+                           Accuracy accuracy,
+                           const allocator_type &allocator = {});
+            // From a program lower_rpn has built, which is optimized in place and keeps its memory resource.
+            ParsedFunction(Program program, Accuracy accuracy);
             double eval(double x, double y) const;
+            double eval(std::span<const double> values) const;
+            // Evaluates every (xs[i], ys[i]) pair into out[i]. All three spans must have the same length.
+            void eval_batch(std::span<const double> xs, std::span<const double> ys, std::span<double> out) const;
+            void eval_batch(std::span<const float> xs, std::span<const float> ys, std::span<float> out) const;
+            // Evaluates row i of the columns, one column per variable, into out[i]. Every span has the same length.
+            void eval_columns(std::span<const std::span<const double>> columns, std::span<double> out) const;
+            void eval_columns(std::span<const std::span<const float>> columns, std::span<float> out) const;
+            // Value and exact partial derivatives in one pass, typically under twice the cost of eval.
+            Gradient eval_with_gradient(double x, double y) const;
+            void eval_batch_with_gradient(std::span<const double> xs,
+                                          std::span<const double> ys,
+                                          std::span<Gradient> out) const;
+            // Sound bounds on the values over the box x × y; see execute_interval.
+            Interval eval_interval(Interval x, Interval y) const;
+            // Cells of a quadtree over `region`, `max_depth` levels deep, which cover the curve f(x, y) = 0.
+            std::vector<Box> implicit_curve_cells(const Box &region, uint32_t max_depth) const;
+            // Samples nx * ny points evenly spaced over [x0, x1] x [y0, y1], endpoints included, into the row-major
+            // `out` (row j holds y = y0 + j * (y1 - y0) / (ny - 1)). Tiles of the grid are spread over `pool`.
+            void eval_grid(double x0,
+                           double x1,
+                           std::size_t nx,
+                           double y0,
+                           double y1,
+                           std::size_t ny,
+                           std::span<double> out,
+                           ThreadPool &pool = ThreadPool::shared()) const;
+            void eval_grid(double x0,
+                           double x1,
+                           std::size_t nx,
+                           double y0,
+                           double y1,
+                           std::size_t ny,
+                           std::span<float> out,
+                           ThreadPool &pool = ThreadPool::shared()) const;
+
+            const Program &program() const { return compiled; }
+            Precision precision() const { return compiled.precision; }
+            Accuracy accuracy() const { return compiled.accuracy; }
+            // One past the highest named variable the function uses; 0 for functions of x and y.
+            uint32_t num_variables() const { return compiled.num_variables; }
+            allocator_type get_allocator() const { return compiled.code.get_allocator(); }
+            const OptimizationStats &optimization_stats() const { return stats; }
+            // Approximate number of bytes the function occupies, including its program.
+            std::size_t memory_usage() const { return sizeof(*this) + compiled.code.capacity() * sizeof(Instruction); }
+#if defined(MATH_PARSER_PROFILING)
+            // Parse phase totals, node counts per kind and what every instruction has cost in eval() so far.
+            Profiling::Report profile() const { return Profiling::make_report(compiled, eval_profile.get()); }
+#endif
 
           private:
-            PTokenEvaluator evaluator;
+            Program compiled;
+            OptimizationStats stats;
+#if defined(MATH_PARSER_PROFILING)
+            std::shared_ptr<Profiling::EvalProfile> eval_profile;
+#endif
         };
 
+        // Stateless: all scratch state lives on the caller's stack and the token table is immutable static data,
+        // so any number of threads may parse at once, through one shared instance or through the static member.
         class ShuntingYardAlgorithm {
 
           public:
-            ParsedFunction parse_text_input(std::string input);
-
-          private:
-            PToken extract_token(std::string &input);
-            PToken find_token_in_map(std::string_view token, std::string *const str = nullptr);
-            void remove_spaces(std::string &input);
-            void format_minus_signs(std::string &input);
-
-          private:
-            static std::map<std::string, PToken, std::greater<>> token_map;
-
-            int expected_number_of_commas = 0u;
+            // The function is allocated from `resource`; see ParsedFunction.
+            static ParsedFunction
+            parse_text_input(std::string_view input,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+            static ParsedFunction
+            parse_text_input(std::string_view input,
+                             Precision precision,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+            static ParsedFunction
+            parse_text_input(std::string_view input,
+                             Precision precision,
+                             Accuracy accuracy,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+            // Over the named `variables` instead of x and y: an identifier matching one of them refers to it, and
+            // x and y are unrecognized unless declared. Names start with a letter or '_' and go on with letters,
+            // digits and '_'.
+            static ParsedFunction
+            parse_text_input(std::string_view input,
+                             std::span<const std::string_view> variables,
+                             Precision precision                 = Precision::Double,
+                             Accuracy accuracy                   = Accuracy::Exact,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+            // The same, except that a malformed formula comes back as a ParseError, with the position of the
+            // problem, instead of being thrown. Nothing is thrown on the way either, so rejecting a formula costs
+            // about as much as accepting one.
+            static ParseResult<ParsedFunction>
+            try_parse_text_input(std::string_view input,
+                                 Precision precision                 = Precision::Double,
+                                 Accuracy accuracy                   = Accuracy::Exact,
+                                 std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+            static ParseResult<ParsedFunction>
+            try_parse_text_input(std::string_view input,
+                                 std::span<const std::string_view> variables,
+                                 Precision precision                 = Precision::Double,
+                                 Accuracy accuracy                   = Accuracy::Exact,
+                                 std::pmr::memory_resource *resource = std::pmr::get_default_resource());
         };
     } // namespace _Internal
 
     inline namespace V2 {
+        using _Internal::Accuracy;
+        using _Internal::Box;
+        using _Internal::Gradient;
+        using _Internal::Interval;
+        using _Internal::ParseError;
+        using _Internal::ParseResult;
         using _Internal::ParsedFunction;
+        using _Internal::Precision;
         using _Internal::ShuntingYardAlgorithm;
+        using _Internal::ThreadPool;
         using namespace Exception;
+        namespace Profiling = _Internal::Profiling;
     } // namespace V2
 
 } // namespace InputHandling
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "math_parser.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Function of x and y with named parameters that change between evaluations, e.g. once per animation
+        // frame. Every subexpression that reads parameters but neither x nor y is computed once per change and kept
+        // as a constant of the program, so evaluation only runs the part that depends on the point. Each of these
+        // cached subexpressions records the parameters it reads, and set() recomputes only those that read one of
+        // the parameters it changes. Nothing is parsed again.
+        //
+        //     const std::string_view names[]{"a", "t"};
+        //     ParameterizedFunction f{"sin(x * a) * exp(-t) + cos(a * t) * y", names};
+        //     const auto t = f.parameter("t");
+        //     for (...) { f.set(t, time); f.eval_batch(xs, ys, out); }
+        //
+        // Parameters start out as 0. The eval* members are const and may run concurrently, but not with set().
+        class ParameterizedFunction {
+          public:
+            // Handle to a parameter, valid for the function that returned it.
+            struct Parameter {
+                uint32_t index{0u};
+            };
+
+            ParameterizedFunction(std::string_view source,
+                                  std::span<const std::string_view> parameters,
+                                  Precision precision = Precision::Double,
+                                  Accuracy accuracy   = Accuracy::Exact);
+
+            Parameter parameter(std::string_view name) const;
+            double get(Parameter parameter) const { return inputs[2u + parameter.index]; }
+            void set(Parameter parameter, double value);
+            // Changes several parameters at once, recomputing what depends on any of them once.
+            void set(std::span<const Parameter> parameters, std::span<const double> values);
+
+            double eval(double x, double y) const;
+            void eval_batch(std::span<const double> xs, std::span<const double> ys, std::span<double> out) const;
+            void eval_batch(std::span<const float> xs, std::span<const float> ys, std::span<float> out) const;
+            // Partial derivatives in x and y; the parameters are held fixed.
+            Gradient eval_with_gradient(double x, double y) const;
+
+            // The program over x and y, with the current values of the cached subexpressions inline.
+            const Program &program() const { return compiled; }
+            std::size_t num_cached() const { return caches.size(); }
+
+          private:
+            struct Cache {
+                Program program;                  // Over `inputs`.
+                std::vector<std::size_t> targets; // Constants of `compiled` that hold its value.
+            };
+
+            void refresh(const Cache &cache);
+
+          private:
+            std::vector<std::string> names;
+            std::vector<double> inputs;                    // x and y (unused, 0), then the parameters.
+            std::vector<Cache> caches;
+            std::vector<std::vector<uint32_t>> dependents; // Per parameter, the caches that read it.
+            Program compiled;
+        };
+    } // namespace _Internal
+
+    inline namespace V2 {
+        using _Internal::ParameterizedFunction;
+    } // namespace V2
+} // namespace InputHandling
@@ -0,0 +1,85 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <variant>
+
+#include "exceptions.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Why a formula was rejected and where: `offset` is the position in the source text of the symbol that
+        // could not be read, the parenthesis without a partner, the function or parenthesis with the wrong number of
+        // arguments, or the operator missing an operand. Each kind corresponds to one of the exceptions.
+        struct ParseError {
+            enum class Kind : uint32_t {
+                MismatchedParenthesis,
+                UnrecognizedSymbol,
+                TooManyOperators,
+                IncorrectNumberOfArguments,
+            };
+
+            Kind kind;
+            uint32_t offset;
+
+            constexpr ParseError(Kind kind, std::size_t offset) : kind{kind}, offset{static_cast<uint32_t>(offset)} {}
+
+            // The what() of that exception.
+            const char *message() const {
+                switch (kind) {
+                case Kind::MismatchedParenthesis: return "You have mismatched parenthesis.";
+                case Kind::TooManyOperators: return "You have too many operators.";
+                case Kind::IncorrectNumberOfArguments: return "Incorrect number of arguments.";
+                case Kind::UnrecognizedSymbol: break;
+                }
+                return "Unrecognized symbol is in the equation.";
+            }
+
+            // Throws the exception this error corresponds to. Not constexpr, so that reaching it while parsing at
+            // compile time is a compile error.
+            [[noreturn]] void raise() const {
+                switch (kind) {
+                case Kind::MismatchedParenthesis: throw Exception::MismatchedParenthesis{};
+                case Kind::TooManyOperators: throw Exception::TooManyOperatorsException{};
+                case Kind::IncorrectNumberOfArguments: throw Exception::IncorrectNumberOfArgumentsException{};
+                case Kind::UnrecognizedSymbol: break;
+                }
+                throw Exception::UnrecognizedSymbolException{};
+            }
+        };
+
+        // Either the result of parsing or why there is none, in the manner of std::expected<T, ParseError>, which
+        // C++20 lacks. Nothing is thrown to produce it; value() throws the exception of the error, if there is one.
+        template <typename T> class ParseResult {
+          public:
+            ParseResult(T value) : result{std::in_place_index<0u>, std::move(value)} {}
+            ParseResult(ParseError error) : result{std::in_place_index<1u>, error} {}
+
+            bool has_value() const { return result.index() == 0u; }
+            explicit operator bool() const { return has_value(); }
+
+            T &value() & { return checked(), std::get<0u>(result); }
+            const T &value() const & { return checked(), std::get<0u>(result); }
+            T &&value() && { return checked(), std::get<0u>(std::move(result)); }
+
+            T &operator*() { return *std::get_if<0u>(&result); }
+            const T &operator*() const { return *std::get_if<0u>(&result); }
+            T *operator->() { return std::get_if<0u>(&result); }
+            const T *operator->() const { return std::get_if<0u>(&result); }
+
+            const ParseError &error() const {
+                assert(("Parsing succeeded, there is no error." && has_value() == false));
+                return *std::get_if<1u>(&result);
+            }
+
+          private:
+            void checked() const {
+                if (has_value() == false) { std::get<1u>(result).raise(); }
+            }
+
+          private:
+            std::variant<T, ParseError> result;
+        };
+    } // namespace _Internal
+} // namespace InputHandling
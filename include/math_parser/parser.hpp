@@ -0,0 +1,255 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "keywords.hpp"
+#include "lexer.hpp"
+#include "parse_error.hpp"
+#include "profiler.hpp"
+#include "program.hpp"
+#include "tokens.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // The grammar, in two steps shared by the run-time parser and the compile-time front end in
+        // static_expression.hpp. Both are constexpr: errors that are thrown at run time become compile errors
+        // during constant evaluation. The try_ forms report errors without throwing; the others throw them.
+
+        // Shunting-yard: infix source text to reverse Polish notation, appended to `tokens`, over the named
+        // `variables` if any are given (see Lexer). Scratch space comes from the allocator of `tokens`.
+        template <typename Allocator>
+        constexpr std::optional<ParseError> try_to_rpn(std::string_view source,
+                                                       std::span<const std::string_view> variables,
+                                                       std::vector<Lexeme, Allocator> &tokens) {
+            MATH_PARSER_PROFILE_PHASE(ShuntingYard);
+
+            using Kind           = ParseError::Kind;
+            using CountAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint32_t>;
+
+            const auto allocator = tokens.get_allocator();
+            std::vector<Lexeme, Allocator> ops{allocator};
+            // Number of arguments seen so far inside every open parenthesis, innermost last.
+            std::vector<uint32_t, CountAllocator> arguments{CountAllocator{allocator}};
+
+            ops.reserve(source.size());
+            tokens.reserve(tokens.size() + source.size());
+
+            Lexer lexer{source, variables};
+            Lexeme previous_token;
+            while (lexer.done() == false) {
+                Lexeme lexeme;
+                {
+                    MATH_PARSER_PROFILE_PHASE(Tokenize);
+                    lexeme = lexer.next();
+                }
+                if (lexeme.token == nullptr) { return ParseError{Kind::UnrecognizedSymbol, lexeme.offset}; }
+
+                // A minus is unary unless it follows something that ends an operand.
+                const auto previous      = previous_token.token;
+                const bool after_operand = previous
+                                           && (is_type_of(previous, Type::Operand)
+                                               || (is_type_of(previous, Type::Operator)
+                                                   && to_oprt(previous)->op == Operator::ClosingParenthesis));
+                if (is_type_of(lexeme.token, Type::Operator) && to_oprt(lexeme.token)->op == Operator::Sub
+                    && after_operand == false) {
+                    lexeme.token = token_of(Operator::Neg);
+                }
+                previous_token   = lexeme;
+                const auto token = lexeme.token;
+
+                if (is_type_of(token, Type::Operand)) {
+                    tokens.push_back(lexeme);
+                } else if (is_type_of(token, Type::Function)) {
+                    ops.push_back(lexeme);
+                } else if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::OpeningParenthesis) {
+                    ops.push_back(lexeme);
+                    arguments.push_back(1u);
+                } else if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::Comma) {
+                    // The previous argument is complete: flush its operators down to the enclosing parenthesis.
+                    while (ops.empty() == false
+                           && (is_type_of(ops.back().token, Type::Operator) == false
+                               || to_oprt(ops.back().token)->op != Operator::OpeningParenthesis)) {
+                        tokens.push_back(ops.back());
+                        ops.pop_back();
+                    }
+
+                    if (arguments.empty()) { return ParseError{Kind::IncorrectNumberOfArguments, lexeme.offset}; }
+                    ++arguments.back();
+                } else if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::ClosingParenthesis) {
+                    while (ops.empty() == false) {
+                        if (is_type_of(ops.back().token, Type::Operator)
+                            && to_oprt(ops.back().token)->op == Operator::OpeningParenthesis) {
+                            break;
+                        }
+
+                        if (ops.size() == 1) { return ParseError{Kind::MismatchedParenthesis, lexeme.offset}; }
+
+                        tokens.push_back(ops.back());
+                        ops.pop_back();
+                    }
+
+                    if (ops.empty() == true || is_type_of(ops.back().token, Type::Operator) == false
+                        || to_oprt(ops.back().token)->op != Operator::OpeningParenthesis) {
+                        return ParseError{Kind::MismatchedParenthesis, lexeme.offset};
+                    }
+
+                    const auto opening = ops.back();
+                    ops.pop_back();
+
+                    const auto num_args = arguments.back();
+                    arguments.pop_back();
+
+                    if (ops.empty() == false && is_type_of(ops.back().token, Type::Function)) {
+                        if (num_args != to_func(ops.back().token)->num_args) {
+                            return ParseError{Kind::IncorrectNumberOfArguments, ops.back().offset};
+                        }
+
+                        tokens.push_back(ops.back());
+                        ops.pop_back();
+                    } else if (num_args != 1u) {
+                        return ParseError{Kind::IncorrectNumberOfArguments, opening.offset};
+                    }
+                } else if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::Neg) {
+                    // Prefix operators have no left operand yet, so nothing on the stack can be reduced.
+                    ops.push_back(lexeme);
+                } else if (*token == Type::Operator) {
+                    // A binary operator without a left operand is the operator too many, not the one before it.
+                    if (after_operand == false) { return ParseError{Kind::TooManyOperators, lexeme.offset}; }
+
+                    while (ops.empty() == false && ops.back().token->type == Type::Operator) {
+                        const auto op1 = to_oprt(token);
+                        const auto op2 = to_oprt(ops.back().token);
+
+                        if (op2->op == Operator::OpeningParenthesis) { break; }
+                        if (op1->precedence > op2->precedence) { break; }
+                        if (op1->precedence == op2->precedence && op1->left_associative == false) { break; }
+
+                        tokens.push_back(ops.back());
+                        ops.pop_back();
+                    }
+
+                    ops.push_back(lexeme);
+                }
+            }
+
+            while (ops.empty() == false) {
+                if (is_type_of(ops.back().token, Type::Operator)
+                    && to_oprt(ops.back().token)->op == Operator::OpeningParenthesis) {
+
+                    return ParseError{Kind::MismatchedParenthesis, ops.back().offset};
+                }
+
+                tokens.push_back(ops.back());
+                ops.pop_back();
+            }
+
+            return std::nullopt;
+        }
+
+        template <typename Allocator = std::allocator<Lexeme>>
+        constexpr std::vector<Lexeme, Allocator> to_rpn(std::string_view source,
+                                                        std::span<const std::string_view> variables = {},
+                                                        const Allocator &allocator                  = {}) {
+            std::vector<Lexeme, Allocator> tokens{allocator};
+            if (const auto error = try_to_rpn(source, variables, tokens)) { error->raise(); }
+            return tokens;
+        }
+
+        // Checks that every operator and function has its operands and lowers the RPN to postfix instructions,
+        // which are appended to `code`. Sets `stack_size` to the stack size the instructions need.
+        template <typename Code>
+        constexpr std::optional<ParseError> try_lower_rpn_into(std::span<const Lexeme> rpn,
+                                                               Code &code,
+                                                               uint32_t &stack_size,
+                                                               Precision precision = Precision::Double) {
+            MATH_PARSER_PROFILE_PHASE(Lower);
+
+            using Kind = ParseError::Kind;
+
+            stack_size     = 0u;
+            uint32_t depth = 0u;
+
+            code.reserve(code.size() + rpn.size());
+            for (const auto &lexeme : rpn) {
+                const auto token = lexeme.token;
+
+                switch (token->type) {
+                case Type::Operand: {
+                    switch (to_opnd(token)->o) {
+                    case Operand::X: code.push_back({.op = OpCode::X}); break;
+                    case Operand::Y: code.push_back({.op = OpCode::Y}); break;
+                    case Operand::Variable:
+                        code.push_back({.op = OpCode::Variable, .slot = lexeme.variable});
+                        break;
+                    case Operand::Number:
+                        code.push_back({.op    = OpCode::Constant,
+                                        .value = precision == Precision::Single ? lexeme.single : lexeme.number});
+                        break;
+                    }
+                    ++depth;
+                    break;
+                }
+                case Type::Function: {
+                    const auto num_args = to_func(token)->num_args;
+                    if (depth < num_args) { return ParseError{Kind::IncorrectNumberOfArguments, lexeme.offset}; }
+
+                    code.push_back({.op = to_opcode(to_func(token)->func)});
+                    depth -= num_args - 1u;
+                    break;
+                }
+                case Type::Operator: {
+                    const auto op = to_opcode(to_oprt(token)->op);
+                    if (depth < arity(op)) { return ParseError{Kind::TooManyOperators, lexeme.offset}; }
+
+                    code.push_back({.op = op});
+                    depth -= arity(op) - 1u;
+                    break;
+                }
+                }
+
+                stack_size = std::max(stack_size, depth);
+            }
+
+            // Nothing at all, or operands left over without an operator to join them, reported at the last one.
+            if (depth != 1u) { return ParseError{Kind::UnrecognizedSymbol, rpn.empty() ? 0u : rpn.back().offset}; }
+
+            return std::nullopt;
+        }
+
+        template <typename Code>
+        constexpr uint32_t
+        lower_rpn_into(std::span<const Lexeme> rpn, Code &code, Precision precision = Precision::Double) {
+            uint32_t stack_size = 0u;
+            if (const auto error = try_lower_rpn_into(rpn, code, stack_size, precision)) { error->raise(); }
+            return stack_size;
+        }
+
+        // The program is allocated from `resource`.
+        inline ParseResult<Program>
+        try_lower_rpn(std::span<const Lexeme> rpn,
+                      Precision precision                 = Precision::Double,
+                      std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+            Program program{.code = std::pmr::vector<Instruction>{resource}, .precision = precision};
+            if (const auto error = try_lower_rpn_into(rpn, program.code, program.stack_size, precision)) {
+                return *error;
+            }
+            for (const auto &ins : program.code) {
+                if (ins.op != OpCode::Variable) { continue; }
+                program.num_variables = std::max(program.num_variables, ins.slot + 1u);
+            }
+            return program;
+        }
+
+        inline Program lower_rpn(std::span<const Lexeme> rpn,
+                                 Precision precision                 = Precision::Double,
+                                 std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+            return try_lower_rpn(rpn, precision, resource).value();
+        }
+    } // namespace _Internal
+} // namespace InputHandling
@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "program.hpp"
+
+// Opt-in instrumentation of parsing and evaluation, enabled by configuring with MATH_PARSER_ENABLE_PROFILING (which
+// defines MATH_PARSER_PROFILING). Without it the probes below expand to nothing and evaluation is not instrumented.
+#if defined(MATH_PARSER_PROFILING)
+#define MATH_PARSER_PROFILE_PHASE(phase)                                                                              \
+    ::InputHandling::_Internal::Profiling::ScopedTimer math_parser_phase_timer {                                      \
+        ::InputHandling::_Internal::Profiling::Phase::phase                                                           \
+    }
+#else
+#define MATH_PARSER_PROFILE_PHASE(phase) static_cast<void>(0)
+#endif
+
+namespace InputHandling {
+    namespace _Internal {
+        namespace Profiling {
+            // Stages of parse_text_input. Parse spans the whole call and ShuntingYard includes Tokenize.
+            enum class Phase { Parse, Tokenize, ShuntingYard, Lower, Optimize };
+            constexpr std::size_t num_phases = static_cast<std::size_t>(Phase::Optimize) + 1u;
+
+            std::string_view name_of(Phase phase);
+            std::string_view name_of(OpCode op);
+
+            uint64_t now_ns();
+            // Adds one timed call of `phase` to the process-wide totals.
+            void record(Phase phase, uint64_t nanoseconds);
+
+            // Times its scope. It does nothing during constant evaluation, so it may live in constexpr functions.
+            class ScopedTimer {
+              public:
+                constexpr explicit ScopedTimer(Phase phase) : phase{phase} {
+                    if (std::is_constant_evaluated() == false) { start = now_ns(); }
+                }
+                constexpr ~ScopedTimer() {
+                    if (std::is_constant_evaluated() == false) { record(phase, now_ns() - start); }
+                }
+                ScopedTimer(const ScopedTimer &)            = delete;
+                ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+              private:
+                Phase phase;
+                uint64_t start{0u};
+            };
+
+            // Cheapest monotonic counter available: the time stamp counter on x86, nanoseconds elsewhere.
+            uint64_t ticks();
+
+            // Ticks a probe adds to every timed instruction, which reports subtract.
+            uint64_t probe_overhead();
+
+            // Per-instruction counters of one program, updated by execute_profiled from any number of threads.
+            struct EvalProfile {
+                explicit EvalProfile(std::size_t num_instructions)
+                    : evaluations(num_instructions), ticks(num_instructions) {}
+
+                std::vector<std::atomic<uint64_t>> evaluations;
+                std::vector<std::atomic<uint64_t>> ticks;
+            };
+
+            struct PhaseReport {
+                Phase phase;
+                uint64_t calls{0u};
+                uint64_t nanoseconds{0u};
+            };
+
+            struct NodeReport {
+                uint32_t index{0u}; // Position in the program.
+                OpCode op;
+                uint64_t evaluations{0u};
+                uint64_t ticks{0u};
+            };
+
+            struct OpCodeReport {
+                OpCode op;
+                std::size_t nodes{0u}; // Instructions of this kind in the program.
+                uint64_t evaluations{0u};
+                uint64_t ticks{0u};
+            };
+
+            struct Report {
+                std::vector<PhaseReport> phases; // Process-wide.
+                std::vector<OpCodeReport> kinds; // Sorted by ticks, most expensive first.
+                std::vector<NodeReport> nodes;
+
+                std::string to_json() const;
+            };
+
+            std::vector<PhaseReport> phase_report();
+            void reset_phases();
+
+            // Combines the phase totals with the node counts of `program` and, if given, its evaluation counters.
+            Report make_report(const Program &program, const EvalProfile *profile);
+        } // namespace Profiling
+
+        // execute() which also counts and times every instruction into `profile`.
+        double execute_profiled(const ProgramView &program, double x, double y, Profiling::EvalProfile &profile);
+    } // namespace _Internal
+} // namespace InputHandling
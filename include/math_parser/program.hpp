@@ -0,0 +1,224 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "tokens.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // Instruction set of the compiled form of an expression. Operands are pushed on an evaluation stack,
+        // everything else pops its arguments and pushes the result back.
+        enum class OpCode : uint32_t {
+            X,
+            Y,
+            // Pushes input `slot`, one of the variables declared when parsing. X and Y are inputs 0 and 1.
+            Variable,
+            Constant,
+            // Copies the top of the stack into a slot without popping it, so a shared subexpression computed once
+            // can be pushed again later with Load.
+            Store,
+            Load,
+            // Pops the top of the stack into output `slot`. Only fused programs, which compute several expressions
+            // at once, contain it.
+            Output,
+
+            Add,
+            Sub,
+            Mul,
+            Div,
+            Pow,
+            Neg,
+
+            Sin,
+            Cos,
+            Tan,
+            Sec,
+            Csc,
+            Cot,
+            Asin,
+            Acos,
+            Atan,
+            Sinh,
+            Cosh,
+            Tanh,
+            Sech,
+            Csch,
+            Coth,
+            Asinh,
+            Acosh,
+            Atanh,
+            Max,
+            Min,
+            Log,
+            Ln,
+            Abs,
+            Exp,
+            Sign,
+            Floor,
+            Ceil,
+            Trunc,
+            Fract,
+            Clamp,
+            Mix,
+            Step,
+            Smoothstep,
+
+            // Only optimize() emits these, in place of costlier equivalents. Square is a * a and Sqrt the square root
+            // with the special cases of pow(a, 0.5): +0 for -0 and +inf for -inf. MulAdd is a * b + c, rounded once.
+            Square,
+            Sqrt,
+            MulAdd
+        };
+
+        struct Instruction {
+            OpCode op;
+            uint32_t slot{0u}; // Operand of OpCode::Variable, OpCode::Store, OpCode::Load and OpCode::Output.
+            double value{0.};  // Immediate operand of OpCode::Constant.
+        };
+
+        // Scalar type the arithmetic of a program is carried out in. Single halves the memory traffic and doubles the
+        // SIMD lanes of batched evaluation; its constants are rounded to float once, directly from the source text.
+        enum class Precision : uint32_t { Double, Single };
+
+        // How exp, ln, log and the trigonometric and hyperbolic functions are computed. Exact calls libm; Fast uses the
+        // polynomial approximations of fast_math.hpp, which batched evaluation runs a whole pack at a time, within the
+        // few ulp documented there. Fast also lets optimize() trade a few ulp for cheaper operations, such as x^3 as
+        // x * x * x.
+        enum class Accuracy : uint32_t { Exact, Fast };
+
+        // Non-owning view of a program, which is all the evaluators need.
+        struct ProgramView {
+            std::span<const Instruction> code;
+            uint32_t stack_size{0u};
+            uint32_t num_slots{0u};
+            Precision precision{Precision::Double};
+            uint32_t num_outputs{0u};
+            uint32_t num_variables{0u};
+            Accuracy accuracy{Accuracy::Exact};
+        };
+
+        // Flat postfix program with inline constants. `stack_size` is the deepest the evaluation stack gets and
+        // `num_slots` the number of shared values stored aside while it runs. The code lives in the memory resource
+        // it was created with; copies allocate from the default resource. A fused program computes `num_outputs`
+        // expressions at once and leaves nothing on the stack; every other program has none and leaves its result.
+        // `num_variables` is one past the highest input a program over named variables reads.
+        struct Program {
+            std::pmr::vector<Instruction> code;
+            uint32_t stack_size{0u};
+            uint32_t num_slots{0u};
+            Precision precision{Precision::Double};
+            uint32_t num_outputs{0u};
+            uint32_t num_variables{0u};
+            Accuracy accuracy{Accuracy::Exact};
+
+            ProgramView view() const {
+                return {code, stack_size, num_slots, precision, num_outputs, num_variables, accuracy};
+            }
+        };
+
+        static_assert(static_cast<uint32_t>(OpCode::Smoothstep) - static_cast<uint32_t>(OpCode::Sin)
+                          == static_cast<uint32_t>(Function::Smoothstep),
+                      "Function opcodes must mirror the order of the Function enum.");
+
+        constexpr OpCode to_opcode(Function f) {
+            return static_cast<OpCode>(static_cast<uint32_t>(OpCode::Sin) + static_cast<uint32_t>(f));
+        }
+
+        constexpr OpCode to_opcode(Operator o) {
+            switch (o) {
+            case Operator::Add: return OpCode::Add;
+            case Operator::Sub: return OpCode::Sub;
+            case Operator::Mul: return OpCode::Mul;
+            case Operator::Div: return OpCode::Div;
+            case Operator::Pow: return OpCode::Pow;
+            case Operator::Neg: return OpCode::Neg;
+            default: break;
+            }
+
+            assert(("Operator has no opcode." && false));
+            return OpCode::Add;
+        }
+
+        // Number of values the opcode pops off the stack.
+        constexpr uint32_t arity(OpCode op) {
+            switch (op) {
+            case OpCode::X:
+            case OpCode::Y:
+            case OpCode::Variable:
+            case OpCode::Constant:
+            case OpCode::Store:
+            case OpCode::Load: return 0u;
+            case OpCode::Output: return 1u;
+
+            case OpCode::Add:
+            case OpCode::Sub:
+            case OpCode::Mul:
+            case OpCode::Div:
+            case OpCode::Pow:
+            case OpCode::Max:
+            case OpCode::Min:
+            case OpCode::Step: return 2u;
+
+            case OpCode::Clamp:
+            case OpCode::Mix:
+            case OpCode::Smoothstep:
+            case OpCode::MulAdd: return 3u;
+
+            default: return 1u;
+            }
+        }
+
+        // Number of values the program reads from `values` or `columns`: one per named variable, and x and y if it
+        // uses them. Scans the code, so it is meant for checks rather than every evaluation.
+        inline uint32_t required_inputs(const ProgramView &program) {
+            for (const auto &ins : program.code) {
+                if (ins.op == OpCode::X || ins.op == OpCode::Y) { return std::max(program.num_variables, 2u); }
+            }
+            return program.num_variables;
+        }
+
+        // All evaluate in the precision of the program; the arguments and the result are converted when their
+        // type differs from it. `values` holds one value per input, starting with x and y for programs without
+        // named variables, and has at least required_inputs(program) of them.
+        double execute(const ProgramView &program, double x, double y);
+        float execute(const ProgramView &program, float x, float y);
+        double execute(const ProgramView &program, std::span<const double> values);
+        float execute(const ProgramView &program, std::span<const float> values);
+
+        // Number of points every instruction processes at once in execute_batch.
+        constexpr std::size_t batch_block_size = 256u;
+
+        void execute_batch(const ProgramView &program,
+                           std::span<const double> xs,
+                           std::span<const double> ys,
+                           std::span<double> out);
+        void execute_batch(const ProgramView &program,
+                           std::span<const float> xs,
+                           std::span<const float> ys,
+                           std::span<float> out);
+        // Column-wise: out[i] is the value for columns[0][i], columns[1][i], ... Every span has the same length, and
+        // there are at least required_inputs(program) columns.
+        void execute_columns(const ProgramView &program,
+                             std::span<const std::span<const double>> columns,
+                             std::span<double> out);
+        void execute_columns(const ProgramView &program,
+                             std::span<const std::span<const float>> columns,
+                             std::span<float> out);
+
+        // Evaluation of fused programs: output k of the program goes to out[k], or to outs[k][i] for point i.
+        void execute_fused(const ProgramView &program, double x, double y, std::span<double> out);
+        void execute_fused(const ProgramView &program, float x, float y, std::span<float> out);
+        void execute_fused_batch(const ProgramView &program,
+                                 std::span<const double> xs,
+                                 std::span<const double> ys,
+                                 std::span<const std::span<double>> outs);
+        void execute_fused_batch(const ProgramView &program,
+                                 std::span<const float> xs,
+                                 std::span<const float> ys,
+                                 std::span<const std::span<float>> outs);
+    } // namespace _Internal
+} // namespace InputHandling
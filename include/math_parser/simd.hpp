@@ -0,0 +1,260 @@
+#pragma once
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#if defined(__FMA__)
+#include <immintrin.h>
+#endif
+#endif
+
+namespace InputHandling {
+    namespace _Internal {
+        // Thin wrapper over the widest double and float vectors the target is compiled for (AVX2, SSE2 or plain
+        // scalar). Every operation mirrors the IEEE semantics of its scalar counterpart in kernels.hpp, including NaN
+        // propagation of min/max/clamp, so batched and per-point evaluation return identical bits. Pack<float> holds
+        // twice as many lanes as Pack<double>.
+        namespace Simd {
+            template <typename T> struct PackOf;
+
+#if defined(__AVX2__)
+            template <> struct PackOf<double> {
+                using type = __m256d;
+            };
+            template <> struct PackOf<float> {
+                using type = __m256;
+            };
+
+            inline __m256d load(const double *p) { return _mm256_loadu_pd(p); }
+            inline void store(double *p, __m256d a) { _mm256_storeu_pd(p, a); }
+            inline __m256d broadcast(double v) { return _mm256_set1_pd(v); }
+
+            inline __m256d add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+            inline __m256d sub(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+            inline __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+            inline __m256d div(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+
+            // a > b ? a : b and a < b ? a : b, exactly like maxpd/minpd.
+            inline __m256d greater_of(__m256d a, __m256d b) { return _mm256_max_pd(a, b); }
+            inline __m256d lesser_of(__m256d a, __m256d b) { return _mm256_min_pd(a, b); }
+            // a < b ? t : f
+            inline __m256d select_less(__m256d a, __m256d b, __m256d t, __m256d f) {
+                return _mm256_blendv_pd(f, t, _mm256_cmp_pd(a, b, _CMP_LT_OQ));
+            }
+
+            inline __m256d floor(__m256d a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+            inline __m256d ceil(__m256d a) { return _mm256_round_pd(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC); }
+            inline __m256d trunc(__m256d a) { return _mm256_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+            inline __m256d abs(__m256d a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+            inline __m256d neg(__m256d a) { return _mm256_xor_pd(_mm256_set1_pd(-0.0), a); }
+            inline __m256d sqrt(__m256d a) { return _mm256_sqrt_pd(a); }
+#if defined(__FMA__)
+            inline __m256d mul_add(__m256d a, __m256d b, __m256d c) { return _mm256_fmadd_pd(a, b, c); }
+#endif
+
+            inline __m256d flip_sign(__m256d a, __m256d b) {
+                return _mm256_xor_pd(a, _mm256_and_pd(_mm256_set1_pd(-0.0), b));
+            }
+            inline __m256d scale(__m256d a, __m256d k) {
+                const __m128i biased = _mm_add_epi32(_mm256_cvtpd_epi32(k), _mm_set1_epi32(1023));
+                return _mm256_mul_pd(a, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_cvtepi32_epi64(biased), 52)));
+            }
+            inline __m256d exponent(__m256d a) {
+                const __m256i biased = _mm256_srli_epi64(_mm256_castpd_si256(a), 52);
+                const __m256d magic  = _mm256_set1_pd(0x1p52);
+                return _mm256_sub_pd(_mm256_or_pd(_mm256_castsi256_pd(biased), magic), _mm256_set1_pd(0x1p52 + 1023.));
+            }
+            inline __m256d significand(__m256d a) {
+                const __m256i mantissa = _mm256_and_si256(_mm256_castpd_si256(a), _mm256_set1_epi64x(0xFFFFFFFFFFFFF));
+                return _mm256_or_pd(_mm256_castsi256_pd(mantissa), _mm256_set1_pd(1.));
+            }
+
+            inline __m256 load(const float *p) { return _mm256_loadu_ps(p); }
+            inline void store(float *p, __m256 a) { _mm256_storeu_ps(p, a); }
+            inline __m256 broadcast(float v) { return _mm256_set1_ps(v); }
+
+            inline __m256 add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+            inline __m256 sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+            inline __m256 mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+            inline __m256 div(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+
+            inline __m256 greater_of(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+            inline __m256 lesser_of(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+            inline __m256 select_less(__m256 a, __m256 b, __m256 t, __m256 f) {
+                return _mm256_blendv_ps(f, t, _mm256_cmp_ps(a, b, _CMP_LT_OQ));
+            }
+
+            inline __m256 floor(__m256 a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+            inline __m256 ceil(__m256 a) { return _mm256_round_ps(a, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC); }
+            inline __m256 trunc(__m256 a) { return _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+            inline __m256 abs(__m256 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+            inline __m256 neg(__m256 a) { return _mm256_xor_ps(_mm256_set1_ps(-0.0f), a); }
+            inline __m256 sqrt(__m256 a) { return _mm256_sqrt_ps(a); }
+#if defined(__FMA__)
+            inline __m256 mul_add(__m256 a, __m256 b, __m256 c) { return _mm256_fmadd_ps(a, b, c); }
+#endif
+#elif defined(__SSE2__)
+            template <> struct PackOf<double> {
+                using type = __m128d;
+            };
+            template <> struct PackOf<float> {
+                using type = __m128;
+            };
+
+            inline __m128d load(const double *p) { return _mm_loadu_pd(p); }
+            inline void store(double *p, __m128d a) { _mm_storeu_pd(p, a); }
+            inline __m128d broadcast(double v) { return _mm_set1_pd(v); }
+
+            inline __m128d add(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+            inline __m128d sub(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+            inline __m128d mul(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+            inline __m128d div(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+
+            inline __m128d greater_of(__m128d a, __m128d b) { return _mm_max_pd(a, b); }
+            inline __m128d lesser_of(__m128d a, __m128d b) { return _mm_min_pd(a, b); }
+            inline __m128d select_less(__m128d a, __m128d b, __m128d t, __m128d f) {
+                const auto mask = _mm_cmplt_pd(a, b);
+                return _mm_or_pd(_mm_and_pd(mask, t), _mm_andnot_pd(mask, f));
+            }
+
+            inline __m128d abs(__m128d a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+            inline __m128d neg(__m128d a) { return _mm_xor_pd(_mm_set1_pd(-0.0), a); }
+            inline __m128d sqrt(__m128d a) { return _mm_sqrt_pd(a); }
+#if defined(__FMA__)
+            inline __m128d mul_add(__m128d a, __m128d b, __m128d c) { return _mm_fmadd_pd(a, b, c); }
+#endif
+
+            inline __m128d flip_sign(__m128d a, __m128d b) { return _mm_xor_pd(a, _mm_and_pd(_mm_set1_pd(-0.0), b)); }
+            inline __m128d scale(__m128d a, __m128d k) {
+                const __m128i biased = _mm_add_epi32(_mm_cvtpd_epi32(k), _mm_set1_epi32(1023));
+                const __m128i wide   = _mm_unpacklo_epi32(biased, _mm_setzero_si128());
+                return _mm_mul_pd(a, _mm_castsi128_pd(_mm_slli_epi64(wide, 52)));
+            }
+            inline __m128d exponent(__m128d a) {
+                const __m128i biased = _mm_srli_epi64(_mm_castpd_si128(a), 52);
+                const __m128d magic  = _mm_set1_pd(0x1p52);
+                return _mm_sub_pd(_mm_or_pd(_mm_castsi128_pd(biased), magic), _mm_set1_pd(0x1p52 + 1023.));
+            }
+            inline __m128d significand(__m128d a) {
+                const __m128i mantissa = _mm_and_si128(_mm_castpd_si128(a), _mm_set1_epi64x(0xFFFFFFFFFFFFF));
+                return _mm_or_pd(_mm_castsi128_pd(mantissa), _mm_set1_pd(1.));
+            }
+
+            inline __m128 load(const float *p) { return _mm_loadu_ps(p); }
+            inline void store(float *p, __m128 a) { _mm_storeu_ps(p, a); }
+            inline __m128 broadcast(float v) { return _mm_set1_ps(v); }
+
+            inline __m128 add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+            inline __m128 sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+            inline __m128 mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+            inline __m128 div(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+
+            inline __m128 greater_of(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+            inline __m128 lesser_of(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+            inline __m128 select_less(__m128 a, __m128 b, __m128 t, __m128 f) {
+                const auto mask = _mm_cmplt_ps(a, b);
+                return _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, f));
+            }
+
+            inline __m128 abs(__m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+            inline __m128 neg(__m128 a) { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+            inline __m128 sqrt(__m128 a) { return _mm_sqrt_ps(a); }
+#if defined(__FMA__)
+            inline __m128 mul_add(__m128 a, __m128 b, __m128 c) { return _mm_fmadd_ps(a, b, c); }
+#endif
+
+#if defined(__SSE4_1__)
+            inline __m128d floor(__m128d a) { return _mm_floor_pd(a); }
+            inline __m128d ceil(__m128d a) { return _mm_ceil_pd(a); }
+            inline __m128d trunc(__m128d a) { return _mm_round_pd(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+            inline __m128 floor(__m128 a) { return _mm_floor_ps(a); }
+            inline __m128 ceil(__m128 a) { return _mm_ceil_ps(a); }
+            inline __m128 trunc(__m128 a) { return _mm_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+#else
+            template <typename F> inline __m128d per_lane(__m128d a, F f) {
+                alignas(16) double lanes[2];
+                _mm_store_pd(lanes, a);
+                return _mm_set_pd(f(lanes[1]), f(lanes[0]));
+            }
+            template <typename F> inline __m128 per_lane(__m128 a, F f) {
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, a);
+                return _mm_set_ps(f(lanes[3]), f(lanes[2]), f(lanes[1]), f(lanes[0]));
+            }
+            inline __m128d floor(__m128d a) { return per_lane(a, [](double v) { return std::floor(v); }); }
+            inline __m128d ceil(__m128d a) { return per_lane(a, [](double v) { return std::ceil(v); }); }
+            inline __m128d trunc(__m128d a) { return per_lane(a, [](double v) { return std::trunc(v); }); }
+
+            inline __m128 floor(__m128 a) { return per_lane(a, [](float v) { return std::floor(v); }); }
+            inline __m128 ceil(__m128 a) { return per_lane(a, [](float v) { return std::ceil(v); }); }
+            inline __m128 trunc(__m128 a) { return per_lane(a, [](float v) { return std::trunc(v); }); }
+#endif
+#else
+            template <typename T> struct PackOf {
+                using type = T;
+            };
+
+            template <typename T> inline T load(const T *p) { return *p; }
+            template <typename T> inline void store(T *p, T a) { *p = a; }
+            template <typename T> inline T broadcast(T v) { return v; }
+#endif
+
+            // Scalar forms of the operations, the packs themselves in a scalar build. Code written against them works
+            // on a single double as well as on a pack and, operation for operation, rounds the same way.
+            template <std::floating_point T> inline T add(T a, T b) { return a + b; }
+            template <std::floating_point T> inline T sub(T a, T b) { return a - b; }
+            template <std::floating_point T> inline T mul(T a, T b) { return a * b; }
+            template <std::floating_point T> inline T div(T a, T b) { return a / b; }
+
+            template <std::floating_point T> inline T greater_of(T a, T b) { return a > b ? a : b; }
+            template <std::floating_point T> inline T lesser_of(T a, T b) { return a < b ? a : b; }
+            template <std::floating_point T> inline T select_less(T a, T b, T t, T f) { return a < b ? t : f; }
+
+            template <std::floating_point T> inline T floor(T a) { return std::floor(a); }
+            template <std::floating_point T> inline T ceil(T a) { return std::ceil(a); }
+            template <std::floating_point T> inline T trunc(T a) { return std::trunc(a); }
+            template <std::floating_point T> inline T abs(T a) { return std::abs(a); }
+            template <std::floating_point T> inline T neg(T a) { return -a; }
+            template <std::floating_point T> inline T sqrt(T a) { return std::sqrt(a); }
+            template <std::floating_point T> inline T mul_add(T a, T b, T c) { return std::fma(a, b, c); }
+
+            // Whether the target computes a * b + c with a single rounding in one instruction. Without it mul_add
+            // exists for scalars only, through a much slower library call.
+#if defined(__FMA__)
+            constexpr bool has_fma = true;
+#else
+            constexpr bool has_fma = false;
+#endif
+
+            // a, negated where the sign bit of b is set (-0 included).
+            inline double flip_sign(double a, double b) {
+                return std::bit_cast<double>(std::bit_cast<uint64_t>(a) ^ (std::bit_cast<uint64_t>(b) & (1ull << 63u)));
+            }
+            // a * 2^k for integral k, where 2^k and the result are normal numbers.
+            inline double scale(double a, double k) {
+                return a * std::bit_cast<double>(static_cast<uint64_t>(static_cast<int64_t>(k) + 1023) << 52u);
+            }
+            // Unbiased exponent and significand in [1, 2) of a positive normal number.
+            inline double exponent(double a) {
+                return static_cast<double>(static_cast<int64_t>(std::bit_cast<uint64_t>(a) >> 52u) - 1023);
+            }
+            inline double significand(double a) {
+                return std::bit_cast<double>((std::bit_cast<uint64_t>(a) & 0xFFFFFFFFFFFFFull) | 0x3FF0000000000000ull);
+            }
+
+            template <typename T> using Pack = typename PackOf<T>::type;
+            // Lanes of T per pack.
+            template <typename T> constexpr std::size_t width = sizeof(Pack<T>) / sizeof(T);
+        } // namespace Simd
+    }     // namespace _Internal
+} // namespace InputHandling
@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "kernels.hpp"
+#include "parser.hpp"
+#include "program.hpp"
+
+namespace InputHandling {
+    namespace _Internal {
+        // String literal usable as a template argument.
+        template <std::size_t N> struct FixedString {
+            consteval FixedString(const char (&literal)[N]) { std::copy_n(literal, N, text.begin()); }
+
+            constexpr std::string_view view() const { return {text.data(), N - 1u}; }
+
+            std::array<char, N> text{};
+        };
+
+        // Postfix program of a literal, fixed at compile time. `first[i]` is the index of the first instruction of
+        // the subexpression that instruction i completes, which locates the operands of every node.
+        template <std::size_t Size> struct StaticProgram {
+            std::array<Instruction, Size> code{};
+            std::array<std::size_t, Size> first{};
+        };
+
+        consteval std::size_t static_program_size(std::string_view source) {
+            std::vector<Instruction> code;
+            lower_rpn_into(to_rpn(source), code);
+            return code.size();
+        }
+
+        template <std::size_t Size> consteval StaticProgram<Size> compile_static(std::string_view source) {
+            std::vector<Instruction> code;
+            lower_rpn_into(to_rpn(source), code);
+
+            StaticProgram<Size> result;
+            for (std::size_t i = 0u; i < Size; ++i) {
+                result.code[i] = code[i];
+
+                // The operands end right before the node, each one directly before the one after it.
+                std::size_t first = i;
+                for (uint32_t a = 0u; a < arity(code[i].op); ++a) { first = result.first[first - 1u]; }
+                result.first[i] = first;
+            }
+            return result;
+        }
+
+        // Same semantics as the matching case of execute() in program.cpp.
+        template <OpCode Op> inline double apply(double a, double b = 0., double c = 0.) {
+            if constexpr (Op == OpCode::Add) { return a + b; }
+            else if constexpr (Op == OpCode::Sub) { return a - b; }
+            else if constexpr (Op == OpCode::Mul) { return a * b; }
+            else if constexpr (Op == OpCode::Div) { return a / b; }
+            else if constexpr (Op == OpCode::Pow) { return std::pow(a, b); }
+            else if constexpr (Op == OpCode::Neg) { return -a; }
+
+            else if constexpr (Op == OpCode::Sin) { return std::sin(a); }
+            else if constexpr (Op == OpCode::Cos) { return std::cos(a); }
+            else if constexpr (Op == OpCode::Tan) { return std::tan(a); }
+            else if constexpr (Op == OpCode::Sec) { return Kernels::sec(a); }
+            else if constexpr (Op == OpCode::Csc) { return Kernels::csc(a); }
+            else if constexpr (Op == OpCode::Cot) { return Kernels::cot(a); }
+
+            else if constexpr (Op == OpCode::Sinh) { return std::sinh(a); }
+            else if constexpr (Op == OpCode::Cosh) { return std::cosh(a); }
+            else if constexpr (Op == OpCode::Tanh) { return std::tanh(a); }
+            else if constexpr (Op == OpCode::Sech) { return Kernels::sech(a); }
+            else if constexpr (Op == OpCode::Csch) { return Kernels::csch(a); }
+            else if constexpr (Op == OpCode::Coth) { return Kernels::coth(a); }
+
+            else if constexpr (Op == OpCode::Asin) { return std::asin(a); }
+            else if constexpr (Op == OpCode::Acos) { return std::acos(a); }
+            else if constexpr (Op == OpCode::Atan) { return std::atan(a); }
+
+            else if constexpr (Op == OpCode::Asinh) { return std::asinh(a); }
+            else if constexpr (Op == OpCode::Acosh) { return std::acosh(a); }
+            else if constexpr (Op == OpCode::Atanh) { return std::atanh(a); }
+
+            else if constexpr (Op == OpCode::Ln) { return std::log(a); }
+            else if constexpr (Op == OpCode::Log) { return std::log10(a); }
+            else if constexpr (Op == OpCode::Abs) { return std::abs(a); }
+            else if constexpr (Op == OpCode::Exp) { return std::exp(a); }
+            else if constexpr (Op == OpCode::Sign) { return Kernels::sign(a); }
+            else if constexpr (Op == OpCode::Floor) { return std::floor(a); }
+            else if constexpr (Op == OpCode::Ceil) { return std::ceil(a); }
+            else if constexpr (Op == OpCode::Trunc) { return std::trunc(a); }
+            else if constexpr (Op == OpCode::Fract) { return Kernels::fract(a); }
+
+            else if constexpr (Op == OpCode::Max) { return Kernels::max(a, b); }
+            else if constexpr (Op == OpCode::Min) { return Kernels::min(a, b); }
+            else if constexpr (Op == OpCode::Step) { return Kernels::step(a, b); }
+
+            else if constexpr (Op == OpCode::Clamp) { return Kernels::clamp(a, b, c); }
+            else if constexpr (Op == OpCode::Mix) { return Kernels::mix(a, b, c); }
+            else if constexpr (Op == OpCode::Smoothstep) { return Kernels::smoothstep(a, b, c); }
+            else { static_assert(Op == OpCode::Add, "Opcode has no kernel."); }
+        }
+
+        // Expression parsed and checked entirely at compile time, with the same grammar as ShuntingYardAlgorithm.
+        // A malformed literal is a compile error. The call operator expands into straight-line code with one
+        // kernel call per node and no dispatch. It is not optimized, and returns the same bits as ParsedFunction::eval
+        // of the text with the default accuracy, signed zeros included, except where the text raises to the constant
+        // power 2 or -1: eval computes those correctly rounded as x * x and 1 / x, while pow here may be 1 ulp off.
+        //
+        //     constexpr auto f = static_expression<"smoothstep(0,1,x*y)">;
+        //     double z = f(0.5, 0.25);
+        template <FixedString Text> struct StaticExpression {
+            static constexpr auto program = compile_static<static_program_size(Text.view())>(Text.view());
+
+            double operator()(double x, double y) const { return node<program.code.size() - 1u>(x, y); }
+
+          private:
+            template <std::size_t I> static double node(double x, double y) {
+                constexpr auto op = program.code[I].op;
+
+                if constexpr (op == OpCode::X) { return x; }
+                else if constexpr (op == OpCode::Y) { return y; }
+                else if constexpr (op == OpCode::Constant) { return program.code[I].value; }
+                else if constexpr (arity(op) == 1u) { return apply<op>(node<I - 1u>(x, y)); }
+                else if constexpr (arity(op) == 2u) {
+                    constexpr auto b = I - 1u;
+                    constexpr auto a = program.first[b] - 1u;
+                    return apply<op>(node<a>(x, y), node<b>(x, y));
+                } else {
+                    constexpr auto c = I - 1u;
+                    constexpr auto b = program.first[c] - 1u;
+                    constexpr auto a = program.first[b] - 1u;
+                    return apply<op>(node<a>(x, y), node<b>(x, y), node<c>(x, y));
+                }
+            }
+        };
+
+        template <FixedString Text> inline constexpr StaticExpression<Text> static_expression{};
+    } // namespace _Internal
+
+    inline namespace V2 {
+        using _Internal::static_expression;
+        using _Internal::StaticExpression;
+    } // namespace V2
+} // namespace InputHandling
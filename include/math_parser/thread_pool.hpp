@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace InputHandling {
+    namespace _Internal {
+        // Fixed-size work-stealing pool. Every worker owns a deque; it takes work from the back of its own
+        // deque and steals from the front of the others once it runs dry.
+        class ThreadPool {
+          public:
+            explicit ThreadPool(std::size_t num_threads = std::thread::hardware_concurrency());
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool &)            = delete;
+            ThreadPool &operator=(const ThreadPool &) = delete;
+
+            std::size_t size() const { return workers.size(); }
+
+            // Runs task(i) for every i in [0, count) and returns once all of them finished. The calling thread
+            // helps with the work, so nested calls from inside a task cannot deadlock. When a task throws, the
+            // tasks not yet started are skipped and the first exception is rethrown once the others are done.
+            void parallel_for(std::size_t count, const std::function<void(std::size_t)> &task);
+
+            // Process-wide pool sized to the number of hardware threads.
+            static ThreadPool &shared();
+
+          private:
+            using Task = std::function<void()>;
+
+            struct WorkQueue {
+                std::mutex mutex;
+                std::deque<Task> tasks;
+            };
+
+            bool try_pop(std::size_t queue_index, Task &task);
+            void worker_loop(std::size_t queue_index);
+
+          private:
+            std::vector<std::unique_ptr<WorkQueue>> queues;
+            std::vector<std::thread> workers;
+
+            std::mutex wake_mutex;
+            std::condition_variable wake;
+            std::atomic<std::size_t> pending{0u};
+            bool stopping = false;
+        };
+    } // namespace _Internal
+} // namespace InputHandling
@@ -50,25 +50,28 @@ namespace InputHandling {
             Mul,
             Div,
             Pow,
+            Neg, // Prefix minus. The lexer only sees '-', the parser tells it apart from Sub by context.
         };
-        enum class Operand { Number, X, Y };
+        enum class Operand { Number, X, Y, Variable };
         enum class Type { Function, Operator, Operand };
 
         struct Token {
-            bool operator==(Type t) const { return t == type; }
+            constexpr bool operator==(Type t) const { return t == type; }
 
             Type type;
         };
 
         struct FunctionToken : public Token {
-            FunctionToken(Function f, uint32_t num_args) : num_args{num_args}, func{f} { type = Type::Function; }
+            constexpr FunctionToken(Function f, uint32_t num_args) : num_args{num_args}, func{f} {
+                type = Type::Function;
+            }
 
             uint32_t num_args = 0;
             Function func;
         };
 
         struct OperatorToken : public Token {
-            OperatorToken(Operator o) : op{o} {
+            constexpr OperatorToken(Operator o) : op{o} {
                 type = Type::Operator;
 
                 switch (o) {
@@ -76,10 +79,15 @@ namespace InputHandling {
                 case Operator::Sub: precedence = 2u; break;
                 case Operator::Mul:
                 case Operator::Div: precedence = 3u; break;
-                case Operator::Pow:
+                // Binds tighter than * and / but looser than ^, so -x^2 is -(x^2) and 2^-x is 2^(-x).
+                case Operator::Neg:
                     precedence       = 4u;
                     left_associative = false;
                     break;
+                case Operator::Pow:
+                    precedence       = 5u;
+                    left_associative = false;
+                    break;
                 default: break;
                 }
             }
@@ -90,8 +98,8 @@ namespace InputHandling {
         };
 
         struct OperandToken : public Token {
-            OperandToken(Operand o) : o{o} { type = Type::Operand; }
-            OperandToken(Operand o, double number) : o{o} {
+            constexpr OperandToken(Operand o) : o{o} { type = Type::Operand; }
+            constexpr OperandToken(Operand o, double number) : o{o} {
                 this->number = number;
                 type         = Type::Operand;
             }
@@ -99,5 +107,10 @@ namespace InputHandling {
             Operand o;
             std::optional<double> number;
         };
+
+        constexpr auto to_oprt    = [](const Token *t) { return static_cast<const OperatorToken *>(t); };
+        constexpr auto to_opnd    = [](const Token *t) { return static_cast<const OperandToken *>(t); };
+        constexpr auto to_func    = [](const Token *t) { return static_cast<const FunctionToken *>(t); };
+        constexpr auto is_type_of = [](const Token *t, Type type) -> bool { return t->type == type; };
     } // namespace _Internal
 } // namespace InputHandling
@@ -0,0 +1,253 @@
+#include "../include/math_parser/archive.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MATH_PARSER_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    constexpr std::size_t code_alignment = 16u;
+
+    std::size_t align_up(std::size_t offset) { return (offset + code_alignment - 1u) & ~(code_alignment - 1u); }
+
+    // Everything execute() and execute_batch() rely on: known opcodes, slots and inputs in range, and a stack that
+    // never underflows, never exceeds stack_size and ends with exactly the result on it.
+    bool is_well_formed(std::span<const Instruction> code,
+                        uint32_t stack_size,
+                        uint32_t num_slots,
+                        uint32_t num_inputs) {
+        if (code.empty() || stack_size > code.size() || num_slots > code.size()) { return false; }
+
+        uint32_t depth = 0u;
+        for (const auto &ins : code) {
+            if (static_cast<uint32_t>(ins.op) > static_cast<uint32_t>(OpCode::MulAdd)) { return false; }
+
+            switch (ins.op) {
+            case OpCode::Store:
+                if (depth == 0u || ins.slot >= num_slots) { return false; }
+                continue;
+            case OpCode::Load:
+                if (ins.slot >= num_slots) { return false; }
+                break;
+            case OpCode::Variable:
+                if (ins.slot >= num_inputs) { return false; }
+                break;
+            case OpCode::Output: return false;
+            default: break;
+            }
+
+            const auto num_args = arity(ins.op);
+            if (depth < num_args) { return false; }
+            depth = depth - num_args + 1u;
+            if (depth > stack_size) { return false; }
+        }
+        return depth == 1u;
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    void ArchiveWriter::add(std::string_view source, const ParsedFunction &function) {
+        add(source, function.program());
+    }
+
+    void ArchiveWriter::add(std::string_view source, const Program &program) {
+        // An entry has a single result; readers have nowhere to put the outputs of a fused program.
+        if (program.num_outputs != 0u) { throw Exception::InvalidArchiveException{}; }
+        // MappedArchive evaluates an entry at x and y only.
+        if (program.num_variables > 2u) { throw Exception::InvalidArchiveException{}; }
+
+        sources.emplace_back(source);
+        programs.push_back(program);
+    }
+
+    void ArchiveWriter::write(std::ostream &out) const {
+        ArchiveHeader header;
+        header.count = programs.size();
+
+        std::vector<ArchiveEntry> entries(programs.size());
+        std::size_t offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry);
+        for (std::size_t i = 0u; i < entries.size(); ++i) {
+            entries[i].source_offset = offset;
+            entries[i].source_length = static_cast<uint32_t>(sources[i].size());
+            offset += sources[i].size();
+        }
+        for (std::size_t i = 0u; i < entries.size(); ++i) {
+            offset                   = align_up(offset);
+            entries[i].code_offset   = offset;
+            entries[i].code_length   = static_cast<uint32_t>(programs[i].code.size());
+            entries[i].stack_size    = programs[i].stack_size;
+            entries[i].num_slots     = programs[i].num_slots;
+            entries[i].precision     = programs[i].precision;
+            entries[i].num_variables = programs[i].num_variables;
+            entries[i].accuracy      = programs[i].accuracy;
+            offset += programs[i].code.size() * sizeof(Instruction);
+        }
+
+        std::size_t written = 0u;
+        const auto put      = [&](const void *bytes, std::size_t size) {
+            out.write(static_cast<const char *>(bytes), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        const auto pad = [&] {
+            static constexpr char zeros[code_alignment]{};
+            put(zeros, align_up(written) - written);
+        };
+
+        put(&header, sizeof header);
+        put(entries.data(), entries.size() * sizeof(ArchiveEntry));
+        for (const auto &source : sources) { put(source.data(), source.size()); }
+        for (const auto &program : programs) {
+            pad();
+            put(program.code.data(), program.code.size() * sizeof(Instruction));
+        }
+    }
+
+    void ArchiveWriter::write(const std::filesystem::path &path) const {
+        std::ofstream out{path, std::ios::binary | std::ios::trunc};
+        if (out.is_open() == false) { throw std::system_error{errno, std::generic_category(), path.string()}; }
+
+        write(out);
+        if (out.flush().fail()) { throw std::system_error{errno, std::generic_category(), path.string()}; }
+    }
+
+    MappedArchive::MappedArchive(const std::filesystem::path &path) {
+#if defined(MATH_PARSER_HAS_MMAP)
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { throw std::system_error{errno, std::generic_category(), path.string()}; }
+
+        struct stat status;
+        if (::fstat(fd, &status) != 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category(), path.string()};
+        }
+
+        length = static_cast<std::size_t>(status.st_size);
+        if (length > 0u) {
+            void *memory = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (memory == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error{error, std::generic_category(), path.string()};
+            }
+            data   = static_cast<const std::byte *>(memory);
+            mapped = true;
+        }
+        ::close(fd);
+#else
+        std::ifstream in{path, std::ios::binary | std::ios::ate};
+        if (in.is_open() == false) { throw std::system_error{errno, std::generic_category(), path.string()}; }
+
+        const auto end = in.tellg();
+        if (end < 0) { throw Exception::InvalidArchiveException{}; }
+
+        length       = static_cast<std::size_t>(end);
+        auto *buffer = new std::byte[length];
+        data         = buffer;
+        if (in.seekg(0).read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(length)).fail()) {
+            release();
+            throw Exception::InvalidArchiveException{};
+        }
+#endif
+
+        try {
+            entries = validate();
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    MappedArchive::~MappedArchive() { release(); }
+
+    MappedArchive::MappedArchive(MappedArchive &&other) noexcept
+        : data{std::exchange(other.data, nullptr)}, length{std::exchange(other.length, 0u)},
+          mapped{std::exchange(other.mapped, false)}, entries{std::exchange(other.entries, {})} {}
+
+    MappedArchive &MappedArchive::operator=(MappedArchive &&other) noexcept {
+        if (this != &other) {
+            release();
+            data    = std::exchange(other.data, nullptr);
+            length  = std::exchange(other.length, 0u);
+            mapped  = std::exchange(other.mapped, false);
+            entries = std::exchange(other.entries, {});
+        }
+        return *this;
+    }
+
+    std::string_view MappedArchive::source(std::size_t i) const {
+        assert(("Archive index out of range." && i < entries.size()));
+        return {reinterpret_cast<const char *>(data + entries[i].source_offset), entries[i].source_length};
+    }
+
+    ProgramView MappedArchive::program(std::size_t i) const {
+        assert(("Archive index out of range." && i < entries.size()));
+        const auto &entry = entries[i];
+        return {{reinterpret_cast<const Instruction *>(data + entry.code_offset), entry.code_length},
+                entry.stack_size,
+                entry.num_slots,
+                entry.precision,
+                0u,
+                entry.num_variables,
+                entry.accuracy};
+    }
+
+    std::span<const ArchiveEntry> MappedArchive::validate() const {
+        if (length < sizeof(ArchiveHeader)) { throw Exception::InvalidArchiveException{}; }
+
+        ArchiveHeader header;
+        std::memcpy(&header, data, sizeof header);
+        if (header.magic != ArchiveHeader::expected_magic || header.version != ArchiveHeader::current_version
+            || header.byte_order != ArchiveHeader::native_byte_order
+            || header.count > (length - sizeof header) / sizeof(ArchiveEntry)) {
+            throw Exception::InvalidArchiveException{};
+        }
+
+        // The header is 24 bytes and the mapping page aligned, so the entries are suitably aligned in place.
+        const std::span index{reinterpret_cast<const ArchiveEntry *>(data + sizeof header), header.count};
+        for (const auto &entry : index) {
+            const bool in_bounds = entry.source_offset <= length && entry.source_length <= length - entry.source_offset
+                                   && entry.code_offset % alignof(Instruction) == 0u && entry.code_offset <= length
+                                   && entry.code_length <= (length - entry.code_offset) / sizeof(Instruction);
+            if (in_bounds == false) { throw Exception::InvalidArchiveException{}; }
+            if (entry.precision != Precision::Double && entry.precision != Precision::Single) {
+                throw Exception::InvalidArchiveException{};
+            }
+            if (entry.accuracy != Accuracy::Exact && entry.accuracy != Accuracy::Fast) {
+                throw Exception::InvalidArchiveException{};
+            }
+            // eval() and eval_batch() pass x and y, so no program may read a third input.
+            if (entry.num_variables > 2u) { throw Exception::InvalidArchiveException{}; }
+
+            const std::span code{reinterpret_cast<const Instruction *>(data + entry.code_offset), entry.code_length};
+            if (is_well_formed(code, entry.stack_size, entry.num_slots, entry.num_variables) == false) {
+                throw Exception::InvalidArchiveException{};
+            }
+        }
+
+        return index;
+    }
+
+    void MappedArchive::release() {
+#if defined(MATH_PARSER_HAS_MMAP)
+        if (mapped) { ::munmap(const_cast<std::byte *>(data), length); }
+#endif
+        if (mapped == false) { delete[] data; }
+
+        data    = nullptr;
+        length  = 0u;
+        mapped  = false;
+        entries = {};
+    }
+} // namespace InputHandling::_Internal
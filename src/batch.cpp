@@ -0,0 +1,386 @@
+#include "../include/math_parser/program.hpp"
+#include "../include/math_parser/fast_math.hpp"
+#include "../include/math_parser/kernels.hpp"
+#include "../include/math_parser/simd.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    // Each helper runs the vector kernel over whole packs and the scalar kernel over the tail, writing into `a`.
+    template <typename T, typename V, typename S> void map1(std::size_t n, T *a, V vop, S sop) {
+        constexpr auto W = Simd::width<T>;
+        std::size_t i    = 0u;
+        for (; i + W <= n; i += W) { Simd::store(a + i, vop(Simd::load(a + i))); }
+        for (; i < n; ++i) { a[i] = sop(a[i]); }
+    }
+
+    template <typename T, typename V, typename S> void map2(std::size_t n, T *a, const T *b, V vop, S sop) {
+        constexpr auto W = Simd::width<T>;
+        std::size_t i    = 0u;
+        for (; i + W <= n; i += W) { Simd::store(a + i, vop(Simd::load(a + i), Simd::load(b + i))); }
+        for (; i < n; ++i) { a[i] = sop(a[i], b[i]); }
+    }
+
+    template <typename T, typename V, typename S>
+    void map3(std::size_t n, T *a, const T *b, const T *c, V vop, S sop) {
+        constexpr auto W = Simd::width<T>;
+        std::size_t i    = 0u;
+        for (; i + W <= n; i += W) {
+            Simd::store(a + i, vop(Simd::load(a + i), Simd::load(b + i), Simd::load(c + i)));
+        }
+        for (; i < n; ++i) { a[i] = sop(a[i], b[i], c[i]); }
+    }
+
+    // Functions without a vector kernel still benefit from running the whole block through one dispatch.
+    template <typename T, typename S> void apply1(std::size_t n, T *a, S sop) {
+        for (std::size_t i = 0u; i < n; ++i) { a[i] = sop(a[i]); }
+    }
+
+    template <typename T, typename S> void apply2(std::size_t n, T *a, const T *b, S sop) {
+        for (std::size_t i = 0u; i < n; ++i) { a[i] = sop(a[i], b[i]); }
+    }
+
+    template <typename T, typename S> void apply3(std::size_t n, T *a, const T *b, const T *c, S sop) {
+        for (std::size_t i = 0u; i < n; ++i) { a[i] = sop(a[i], b[i], c[i]); }
+    }
+
+    // Approximation F of a Fast program, a pack of doubles at a time whatever T is. A pack with a lane outside the
+    // domain of F is done lane by lane, exactly as execute() does it, so both agree bit for bit.
+    template <typename F, typename T> void approximate(std::size_t n, T *a) {
+        constexpr auto W = Simd::width<double>;
+        std::size_t i    = 0u;
+        for (; i + W <= n; i += W) {
+            if (std::all_of(a + i, a + i + W, [](T v) { return F::in_domain(v); }) == false) {
+                std::transform(a + i, a + i + W, a + i, FastMath::evaluate<F, T>);
+            } else if constexpr (std::is_same_v<T, double>) {
+                Simd::store(a + i, F::approximate(Simd::load(a + i)));
+            } else {
+                double lanes[W];
+                std::copy_n(a + i, W, lanes);
+                Simd::store(lanes, F::approximate(Simd::load(lanes)));
+                std::copy_n(lanes, W, a + i);
+            }
+        }
+        for (; i < n; ++i) { a[i] = FastMath::evaluate<F, T>(a[i]); }
+    }
+
+    // libm, or its approximation in a Fast program.
+    template <typename F, typename T, typename S> void transcendental(bool fast, std::size_t n, T *a, S exact) {
+        if (fast) {
+            approximate<F>(n, a);
+        } else {
+            apply1(n, a, exact);
+        }
+    }
+
+    // The Simd operations are overloaded per pack type, so they are passed on through these.
+    const auto vector_add   = [](auto a, auto b) { return Simd::add(a, b); };
+    const auto vector_sub   = [](auto a, auto b) { return Simd::sub(a, b); };
+    const auto vector_mul   = [](auto a, auto b) { return Simd::mul(a, b); };
+    const auto vector_div   = [](auto a, auto b) { return Simd::div(a, b); };
+    const auto vector_neg   = [](auto a) { return Simd::neg(a); };
+    const auto vector_abs   = [](auto a) { return Simd::abs(a); };
+    const auto vector_floor = [](auto a) { return Simd::floor(a); };
+    const auto vector_ceil  = [](auto a) { return Simd::ceil(a); };
+    const auto vector_trunc = [](auto a) { return Simd::trunc(a); };
+
+    // `inputs` holds one block per input, x and y first. `outputs` receives the results of a fused program, one
+    // block each. `fast` selects the approximations of Accuracy::Fast.
+    template <typename T>
+    void run_block(std::span<const Instruction> code,
+                   T *slots,
+                   T *stack,
+                   std::size_t n,
+                   const T *const *inputs,
+                   T *const *outputs,
+                   bool fast) {
+        constexpr auto B = batch_block_size;
+        // `sp` points one block past the topmost stack slot, like the stack pointer in execute().
+        T *sp = stack;
+
+        for (const auto &ins : code) {
+            switch (ins.op) {
+            case OpCode::X: std::memcpy(sp, inputs[0], n * sizeof(T)), sp += B; break;
+            case OpCode::Y: std::memcpy(sp, inputs[1], n * sizeof(T)), sp += B; break;
+            case OpCode::Variable: std::memcpy(sp, inputs[ins.slot], n * sizeof(T)), sp += B; break;
+            case OpCode::Constant: std::fill_n(sp, n, static_cast<T>(ins.value)), sp += B; break;
+            case OpCode::Store: std::memcpy(slots + ins.slot * B, sp - B, n * sizeof(T)); break;
+            case OpCode::Load: std::memcpy(sp, slots + ins.slot * B, n * sizeof(T)), sp += B; break;
+            case OpCode::Output: sp -= B, std::memcpy(outputs[ins.slot], sp, n * sizeof(T)); break;
+
+            case OpCode::Add: sp -= B, map2(n, sp - B, sp, vector_add, std::plus<T>{}); break;
+            case OpCode::Sub: sp -= B, map2(n, sp - B, sp, vector_sub, std::minus<T>{}); break;
+            case OpCode::Mul: sp -= B, map2(n, sp - B, sp, vector_mul, std::multiplies<T>{}); break;
+            case OpCode::Div: sp -= B, map2(n, sp - B, sp, vector_div, std::divides<T>{}); break;
+            case OpCode::Pow:
+                sp -= B;
+                apply2(n, sp - B, sp, [](T a, T b) { return std::pow(a, b); });
+                break;
+
+            case OpCode::Sin: transcendental<FastMath::Sin>(fast, n, sp - B, [](T v) { return std::sin(v); }); break;
+            case OpCode::Cos: transcendental<FastMath::Cos>(fast, n, sp - B, [](T v) { return std::cos(v); }); break;
+            case OpCode::Tan: transcendental<FastMath::Tan>(fast, n, sp - B, [](T v) { return std::tan(v); }); break;
+            case OpCode::Sec: transcendental<FastMath::Sec>(fast, n, sp - B, Kernels::sec<T>); break;
+            case OpCode::Csc: transcendental<FastMath::Csc>(fast, n, sp - B, Kernels::csc<T>); break;
+            case OpCode::Cot: transcendental<FastMath::Cot>(fast, n, sp - B, Kernels::cot<T>); break;
+
+            case OpCode::Sinh: transcendental<FastMath::Sinh>(fast, n, sp - B, [](T v) { return std::sinh(v); }); break;
+            case OpCode::Cosh: transcendental<FastMath::Cosh>(fast, n, sp - B, [](T v) { return std::cosh(v); }); break;
+            case OpCode::Tanh: transcendental<FastMath::Tanh>(fast, n, sp - B, [](T v) { return std::tanh(v); }); break;
+            case OpCode::Sech: transcendental<FastMath::Sech>(fast, n, sp - B, Kernels::sech<T>); break;
+            case OpCode::Csch: transcendental<FastMath::Csch>(fast, n, sp - B, Kernels::csch<T>); break;
+            case OpCode::Coth: transcendental<FastMath::Coth>(fast, n, sp - B, Kernels::coth<T>); break;
+
+            case OpCode::Asin: apply1(n, sp - B, [](T v) { return std::asin(v); }); break;
+            case OpCode::Acos: apply1(n, sp - B, [](T v) { return std::acos(v); }); break;
+            case OpCode::Atan: apply1(n, sp - B, [](T v) { return std::atan(v); }); break;
+
+            case OpCode::Asinh: apply1(n, sp - B, [](T v) { return std::asinh(v); }); break;
+            case OpCode::Acosh: apply1(n, sp - B, [](T v) { return std::acosh(v); }); break;
+            case OpCode::Atanh: apply1(n, sp - B, [](T v) { return std::atanh(v); }); break;
+
+            case OpCode::Ln: transcendental<FastMath::Ln>(fast, n, sp - B, [](T v) { return std::log(v); }); break;
+            case OpCode::Log: transcendental<FastMath::Log>(fast, n, sp - B, [](T v) { return std::log10(v); }); break;
+            case OpCode::Exp: transcendental<FastMath::Exp>(fast, n, sp - B, [](T v) { return std::exp(v); }); break;
+            case OpCode::Sign: apply1(n, sp - B, Kernels::sign<T>); break;
+            case OpCode::Fract: apply1(n, sp - B, Kernels::fract<T>); break;
+
+            case OpCode::Neg: map1(n, sp - B, vector_neg, std::negate<T>{}); break;
+            case OpCode::Abs: map1(n, sp - B, vector_abs, [](T v) { return std::abs(v); }); break;
+            case OpCode::Floor: map1(n, sp - B, vector_floor, [](T v) { return std::floor(v); }); break;
+            case OpCode::Ceil: map1(n, sp - B, vector_ceil, [](T v) { return std::ceil(v); }); break;
+            case OpCode::Trunc: map1(n, sp - B, vector_trunc, [](T v) { return std::trunc(v); }); break;
+
+            case OpCode::Max:
+                sp -= B;
+                map2(n, sp - B, sp, [](auto a, auto b) { return Simd::greater_of(b, a); }, Kernels::max<T>);
+                break;
+            case OpCode::Min:
+                sp -= B;
+                map2(n, sp - B, sp, [](auto a, auto b) { return Simd::lesser_of(b, a); }, Kernels::min<T>);
+                break;
+            case OpCode::Step:
+                sp -= B;
+                map2(
+                    n, sp - B, sp,
+                    [](auto edge, auto v) {
+                        return Simd::select_less(v, edge, Simd::broadcast(T(0)), Simd::broadcast(T(1)));
+                    },
+                    Kernels::step<T>);
+                break;
+
+            case OpCode::Clamp:
+                sp -= 2 * B;
+                map3(
+                    n, sp - B, sp, sp + B,
+                    [](auto v, auto lo, auto hi) { return Simd::lesser_of(hi, Simd::greater_of(lo, v)); },
+                    Kernels::clamp<T>);
+                break;
+            case OpCode::Mix:
+                sp -= 2 * B;
+                map3(
+                    n, sp - B, sp, sp + B,
+                    [](auto a, auto b, auto t) {
+                        return Simd::add(Simd::mul(a, Simd::sub(Simd::broadcast(T(1)), t)), Simd::mul(b, t));
+                    },
+                    Kernels::mix<T>);
+                break;
+            case OpCode::Smoothstep:
+                sp -= 2 * B;
+                map3(
+                    n, sp - B, sp, sp + B,
+                    [](auto e1, auto e2, auto v) {
+                        const auto s = Simd::div(Simd::sub(v, e1), Simd::sub(e2, e1));
+                        const auto t =
+                            Simd::lesser_of(Simd::broadcast(T(1)), Simd::greater_of(Simd::broadcast(T(0)), s));
+                        return Simd::mul(Simd::mul(t, t),
+                                         Simd::sub(Simd::broadcast(T(3)), Simd::mul(Simd::broadcast(T(2)), t)));
+                    },
+                    Kernels::smoothstep<T>);
+                break;
+
+            case OpCode::Square: map1(n, sp - B, [](auto a) { return Simd::mul(a, a); }, Kernels::square<T>); break;
+            case OpCode::Sqrt:
+                map1(
+                    n, sp - B,
+                    [](auto a) {
+                        const auto infinity = Simd::broadcast(std::numeric_limits<T>::infinity());
+                        const auto root     = Simd::add(Simd::sqrt(a), Simd::broadcast(T(0)));
+                        return Simd::select_less(a, Simd::broadcast(std::numeric_limits<T>::lowest()), infinity, root);
+                    },
+                    Kernels::sqrt<T>);
+                break;
+            case OpCode::MulAdd:
+                sp -= 2 * B;
+                if constexpr (Simd::has_fma) {
+                    map3(
+                        n, sp - B, sp, sp + B, [](auto a, auto b, auto c) { return Simd::mul_add(a, b, c); },
+                        Kernels::mul_add<T>);
+                } else {
+                    apply3(n, sp - B, sp, sp + B, Kernels::mul_add<T>);
+                }
+                break;
+            }
+        }
+    }
+
+    // Evaluates `count` points in T, reading input k from columns[k] and writing result k to results[k]; a program
+    // without outputs has the one result left on its stack. When the buffers hold another scalar type U, inputs and
+    // results are converted a block at a time through staging blocks.
+    template <typename T, typename U>
+    void run_columns(const ProgramView &program,
+                     std::span<const U *const> columns,
+                     std::span<U *const> results,
+                     std::size_t count) {
+        constexpr auto B       = batch_block_size;
+        constexpr bool convert = std::is_same_v<T, U> == false;
+
+        // Slots first, then the stack and the staging blocks, one block per entry.
+        const std::size_t staged = convert ? columns.size() + program.num_outputs : 0u;
+        std::vector<T> storage((std::size_t{program.num_slots} + program.stack_size + staged) * B);
+        T *slots   = storage.data();
+        T *stack   = slots + std::size_t{program.num_slots} * B;
+        T *staging = stack + std::size_t{program.stack_size} * B;
+
+        std::vector<const T *> inputs(columns.size());
+        std::vector<T *> targets(program.num_outputs);
+        for (std::size_t offset = 0u; offset < count; offset += B) {
+            const auto n = std::min(B, count - offset);
+
+            for (std::size_t k = 0u; k < inputs.size(); ++k) {
+                if constexpr (convert) {
+                    std::copy_n(columns[k] + offset, n, staging + k * B);
+                    inputs[k] = staging + k * B;
+                } else {
+                    inputs[k] = columns[k] + offset;
+                }
+            }
+            for (std::size_t k = 0u; k < targets.size(); ++k) {
+                if constexpr (convert) {
+                    targets[k] = staging + (inputs.size() + k) * B;
+                } else {
+                    targets[k] = results[k] + offset;
+                }
+            }
+
+            run_block(program.code, slots, stack, n, inputs.data(), targets.data(), program.accuracy == Accuracy::Fast);
+            if (targets.empty()) {
+                std::copy_n(stack, n, results[0] + offset);
+            } else if constexpr (convert) {
+                for (std::size_t k = 0u; k < targets.size(); ++k) { std::copy_n(targets[k], n, results[k] + offset); }
+            }
+        }
+    }
+
+    template <typename T, typename U>
+    void run_batch(const ProgramView &program, std::span<const U> xs, std::span<const U> ys, std::span<U> out) {
+        assert(("Input and output spans must have the same length." && xs.size() == out.size()
+                && ys.size() == out.size()));
+        assert(("The program takes named variables; use execute_columns." && program.num_variables <= 2u));
+
+        const U *const columns[]{xs.data(), ys.data()};
+        U *const results[]{out.data()};
+        run_columns<T, U>(program, columns, results, out.size());
+    }
+
+    template <typename T, typename U>
+    void run_fused(const ProgramView &program,
+                   std::span<const U> xs,
+                   std::span<const U> ys,
+                   std::span<const std::span<U>> outs) {
+        assert(("Output spans must cover every output of the program." && outs.size() == program.num_outputs));
+        assert(("Input and output spans must have the same length." && xs.size() == ys.size()
+                && std::all_of(outs.begin(), outs.end(), [&](const auto &out) { return out.size() == xs.size(); })));
+        assert(("The program takes named variables." && program.num_variables <= 2u));
+
+        const U *const columns[]{xs.data(), ys.data()};
+        std::vector<U *> results(outs.size());
+        std::transform(outs.begin(), outs.end(), results.begin(), [](const auto &out) { return out.data(); });
+        run_columns<T, U>(program, columns, results, xs.size());
+    }
+
+    template <typename T, typename U>
+    void run_table(const ProgramView &program, std::span<const std::span<const U>> columns, std::span<U> out) {
+        assert(("Every input of the program needs a column." && columns.size() >= required_inputs(program)));
+        assert(("Input and output spans must have the same length."
+                && std::all_of(columns.begin(), columns.end(), [&](const auto &c) { return c.size() == out.size(); })));
+
+        std::vector<const U *> inputs(columns.size());
+        std::transform(columns.begin(), columns.end(), inputs.begin(), [](const auto &c) { return c.data(); });
+        U *const results[]{out.data()};
+        run_columns<T, U>(program, inputs, results, out.size());
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    void execute_batch(const ProgramView &program,
+                       std::span<const double> xs,
+                       std::span<const double> ys,
+                       std::span<double> out) {
+        if (program.precision == Precision::Single) {
+            run_batch<float>(program, xs, ys, out);
+        } else {
+            run_batch<double>(program, xs, ys, out);
+        }
+    }
+
+    void execute_batch(const ProgramView &program,
+                       std::span<const float> xs,
+                       std::span<const float> ys,
+                       std::span<float> out) {
+        if (program.precision == Precision::Single) {
+            run_batch<float>(program, xs, ys, out);
+        } else {
+            run_batch<double>(program, xs, ys, out);
+        }
+    }
+
+    void execute_fused_batch(const ProgramView &program,
+                             std::span<const double> xs,
+                             std::span<const double> ys,
+                             std::span<const std::span<double>> outs) {
+        if (program.precision == Precision::Single) {
+            run_fused<float>(program, xs, ys, outs);
+        } else {
+            run_fused<double>(program, xs, ys, outs);
+        }
+    }
+
+    void execute_fused_batch(const ProgramView &program,
+                             std::span<const float> xs,
+                             std::span<const float> ys,
+                             std::span<const std::span<float>> outs) {
+        if (program.precision == Precision::Single) {
+            run_fused<float>(program, xs, ys, outs);
+        } else {
+            run_fused<double>(program, xs, ys, outs);
+        }
+    }
+
+    void execute_columns(const ProgramView &program,
+                         std::span<const std::span<const double>> columns,
+                         std::span<double> out) {
+        if (program.precision == Precision::Single) {
+            run_table<float>(program, columns, out);
+        } else {
+            run_table<double>(program, columns, out);
+        }
+    }
+
+    void execute_columns(const ProgramView &program,
+                         std::span<const std::span<const float>> columns,
+                         std::span<float> out) {
+        if (program.precision == Precision::Single) {
+            run_table<float>(program, columns, out);
+        } else {
+            run_table<double>(program, columns, out);
+        }
+    }
+} // namespace InputHandling::_Internal
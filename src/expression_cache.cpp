@@ -0,0 +1,101 @@
+#include "../include/math_parser/expression_cache.hpp"
+
+#include <functional>
+
+namespace InputHandling::_Internal {
+    ExpressionCache::ExpressionCache(std::size_t memory_limit, std::size_t num_shards)
+        : shard_memory_limit{memory_limit / std::max<std::size_t>(num_shards, 1u)} {
+        shards.resize(std::max<std::size_t>(num_shards, 1u));
+        for (auto &shard : shards) { shard = std::make_unique<Shard>(); }
+    }
+
+    std::shared_ptr<const ParsedFunction> ExpressionCache::get(std::string_view expression) {
+        auto key    = normalize(expression);
+        auto &shard = shard_of(key);
+
+        {
+            std::lock_guard lock{shard.mutex};
+            if (const auto it = shard.index.find(key); it != shard.index.end()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                hits.fetch_add(1u, std::memory_order_relaxed);
+                return it->second->function;
+            }
+        }
+
+        // Parse outside the lock so a slow formula does not stall lookups of other formulas in the same shard.
+        misses.fetch_add(1u, std::memory_order_relaxed);
+        auto function   = std::make_shared<const ParsedFunction>(ShuntingYardAlgorithm{}.parse_text_input(expression));
+        const auto size = sizeof(Entry) + key.capacity() + function->memory_usage();
+
+        std::lock_guard lock{shard.mutex};
+        if (const auto it = shard.index.find(key); it != shard.index.end()) {
+            // Another thread compiled the same formula in the meantime; keep the copy that is already shared.
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->function;
+        }
+
+        shard.lru.push_front({std::move(key), function, size});
+        shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+        shard.memory_usage += size;
+
+        // The entry just added always stays, even if it alone exceeds the limit.
+        while (shard.memory_usage > shard_memory_limit && shard.lru.size() > 1u) {
+            auto &victim = shard.lru.back();
+            shard.memory_usage -= victim.size;
+            shard.index.erase(victim.key);
+            shard.lru.pop_back();
+            evictions.fetch_add(1u, std::memory_order_relaxed);
+        }
+
+        return function;
+    }
+
+    ExpressionCache::Statistics ExpressionCache::statistics() const {
+        Statistics stats;
+        stats.hits      = hits.load(std::memory_order_relaxed);
+        stats.misses    = misses.load(std::memory_order_relaxed);
+        stats.evictions = evictions.load(std::memory_order_relaxed);
+
+        for (const auto &shard : shards) {
+            std::lock_guard lock{shard->mutex};
+            stats.entries += shard->lru.size();
+            stats.memory_usage += shard->memory_usage;
+        }
+        return stats;
+    }
+
+    void ExpressionCache::clear() {
+        for (auto &shard : shards) {
+            std::lock_guard lock{shard->mutex};
+            shard->index.clear();
+            shard->lru.clear();
+            shard->memory_usage = 0u;
+        }
+    }
+
+    std::string ExpressionCache::normalize(std::string_view expression) {
+        // Whitespace only matters between two characters that would otherwise run into one token, as in "1 2" or
+        // "sin x"; every other symbol is a single character.
+        const auto is_word = [](char c) { return is_identifier(c) || c == '.'; };
+
+        std::string normalized;
+        normalized.reserve(expression.size());
+        bool after_space = false;
+        for (const char c : expression) {
+            if (is_space(c)) {
+                after_space = true;
+                continue;
+            }
+            if (after_space && normalized.empty() == false && is_word(normalized.back()) && is_word(c)) {
+                normalized.push_back(' ');
+            }
+            after_space = false;
+            normalized.push_back(c);
+        }
+        return normalized;
+    }
+
+    ExpressionCache::Shard &ExpressionCache::shard_of(std::string_view key) {
+        return *shards[std::hash<std::string_view>{}(key) % shards.size()];
+    }
+} // namespace InputHandling::_Internal
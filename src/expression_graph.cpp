@@ -0,0 +1,164 @@
+#include "../include/math_parser/expression_graph.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    // Replays a program on a stack of node indices, handing every node to `add`, and returns the root.
+    template <typename Add>
+    uint32_t read_program(std::span<const Instruction> code, std::pmr::memory_resource *scratch, Add add) {
+        std::pmr::vector<uint32_t> stack{scratch};
+        std::pmr::vector<uint32_t> slots{scratch};
+
+        for (const auto &ins : code) {
+            if (ins.op == OpCode::Store) {
+                slots.resize(std::max<std::size_t>(slots.size(), ins.slot + 1u));
+                slots[ins.slot] = stack.back();
+                continue;
+            }
+            if (ins.op == OpCode::Load) {
+                stack.push_back(slots[ins.slot]);
+                continue;
+            }
+            assert(("Fused programs cannot be read back." && ins.op != OpCode::Output));
+
+            ExpressionNode node{ins.op, ins.value};
+            if (ins.op == OpCode::Variable) { node.input = ins.slot; }
+
+            const auto num_args = arity(ins.op);
+            assert(stack.size() >= num_args);
+            for (uint32_t i = 0u; i < num_args; ++i) { node.args[i] = stack[stack.size() - num_args + i]; }
+            stack.resize(stack.size() - num_args);
+
+            stack.push_back(add(node));
+        }
+
+        assert(stack.size() == 1u);
+        return stack.back();
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    std::size_t ExpressionNodeHash::operator()(const ExpressionNode &node) const {
+        std::size_t h = static_cast<std::size_t>(node.op);
+        const auto combine = [&h](uint64_t v) { h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); };
+
+        combine(std::bit_cast<uint64_t>(node.value));
+        for (const auto arg : node.args) { combine(arg); }
+        combine(node.input);
+        return h;
+    }
+
+    bool ExpressionNodeEqual::operator()(const ExpressionNode &a, const ExpressionNode &b) const {
+        // Constants compare by representation so that 0 and -0 stay apart and equal NaNs are merged.
+        return a.op == b.op && std::bit_cast<uint64_t>(a.value) == std::bit_cast<uint64_t>(b.value)
+               && a.args == b.args && a.input == b.input;
+    }
+
+    uint32_t ExpressionGraph::add(const ExpressionNode &node) {
+        nodes.push_back(node);
+        return static_cast<uint32_t>(nodes.size() - 1u);
+    }
+
+    uint32_t ExpressionGraph::intern(const ExpressionNode &node) {
+        const auto [it, inserted] = interned.try_emplace(node, static_cast<uint32_t>(nodes.size()));
+        if (inserted) { nodes.push_back(node); }
+
+        return it->second;
+    }
+
+    ExpressionGraph ExpressionGraph::from_program(std::span<const Instruction> code,
+                                                  std::pmr::memory_resource *resource) {
+        ExpressionGraph graph{resource};
+        graph.nodes.reserve(code.size());
+        graph.root = read_program(code, resource, [&graph](const ExpressionNode &node) { return graph.add(node); });
+        return graph;
+    }
+
+    uint32_t ExpressionGraph::merge(std::span<const Instruction> code) {
+        return read_program(code, nodes.get_allocator().resource(), [this](const ExpressionNode &node) {
+            return intern(node);
+        });
+    }
+
+    Program ExpressionGraph::to_program(std::pmr::memory_resource *resource) const {
+        return lower(std::span{&root, 1u}, false, resource);
+    }
+
+    Program ExpressionGraph::to_subprogram(uint32_t node, std::pmr::memory_resource *resource) const {
+        return lower(std::span{&node, 1u}, false, resource);
+    }
+
+    Program ExpressionGraph::to_fused_program(std::span<const uint32_t> roots,
+                                              std::pmr::memory_resource *resource) const {
+        return lower(roots, true, resource);
+    }
+
+    Program ExpressionGraph::lower(std::span<const uint32_t> roots,
+                                   bool fused,
+                                   std::pmr::memory_resource *resource) const {
+        // Scratch space comes from the same resource as the graph itself.
+        const auto scratch = nodes.get_allocator().resource();
+
+        // Count how often every node reachable from the roots is used. Arguments precede their users, so one
+        // backwards sweep sees all users of a node before the node itself.
+        std::pmr::vector<uint32_t> uses(nodes.size(), 0u, scratch);
+        for (const auto r : roots) { ++uses[r]; }
+        for (auto i = nodes.size(); i-- > 0u;) {
+            if (uses[i] == 0u) { continue; }
+            for (uint32_t a = 0u; a < arity(nodes[i].op); ++a) { ++uses[nodes[i].args[a]]; }
+        }
+
+        constexpr auto no_slot = UINT32_MAX;
+        std::pmr::vector<uint32_t> slot_of(nodes.size(), no_slot, scratch);
+
+        Program program{.code = std::pmr::vector<Instruction>{resource}};
+        uint32_t depth = 0u;
+        const auto emit = [&](const Instruction &ins) {
+            program.code.push_back(ins);
+            if (ins.op == OpCode::Output) {
+                --depth;
+            } else if (ins.op != OpCode::Store) {
+                depth = depth + 1u - arity(ins.op);
+            }
+            program.stack_size = std::max(program.stack_size, depth);
+        };
+
+        // Post-order walk from each root; nodes that no longer contribute to any root are never emitted.
+        std::pmr::vector<std::pair<uint32_t, uint32_t>> pending{scratch};
+        for (std::size_t output = 0u; output < roots.size(); ++output) {
+            pending.push_back({roots[output], 0u});
+            while (pending.empty() == false) {
+                const auto [index, visited_args] = pending.back();
+                const auto &node                 = nodes[index];
+
+                if (slot_of[index] != no_slot) {
+                    emit({.op = OpCode::Load, .slot = slot_of[index]});
+                    pending.pop_back();
+                    continue;
+                }
+                if (visited_args < arity(node.op)) {
+                    pending.back().second = visited_args + 1u;
+                    pending.push_back({node.args[visited_args], 0u});
+                    continue;
+                }
+
+                emit({.op = node.op, .slot = node.input, .value = node.value});
+                // Leaves are as cheap to push again as a Load, so only computed values are shared.
+                if (uses[index] > 1u && arity(node.op) > 0u) {
+                    slot_of[index] = program.num_slots++;
+                    emit({.op = OpCode::Store, .slot = slot_of[index]});
+                }
+                pending.pop_back();
+            }
+
+            if (fused) { emit({.op = OpCode::Output, .slot = static_cast<uint32_t>(output)}); }
+        }
+        if (fused) { program.num_outputs = static_cast<uint32_t>(roots.size()); }
+
+        return program;
+    }
+} // namespace InputHandling::_Internal
@@ -0,0 +1,66 @@
+#include "../include/math_parser/fused.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    std::size_t count_nodes(const Program &program) {
+        return std::count_if(program.code.begin(), program.code.end(), [](const Instruction &ins) {
+            return ins.op != OpCode::Store && ins.op != OpCode::Load && ins.op != OpCode::Output;
+        });
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    FusedFunction::FusedFunction(std::span<const ParsedFunction> functions) {
+        assert(("A fused function needs at least one function." && functions.empty() == false));
+
+        std::array<std::byte, 16384> buffer;
+        std::pmr::monotonic_buffer_resource scratch{buffer.data(), buffer.size()};
+
+        // Every function is already optimized on its own; interning them into one graph merges what they share.
+        ExpressionGraph graph{&scratch};
+        std::pmr::vector<uint32_t> roots{&scratch};
+        for (const auto &function : functions) {
+            assert(("Fused functions must have the same precision."
+                    && function.precision() == functions.front().precision()));
+            assert(("Fused functions must have the same accuracy."
+                    && function.accuracy() == functions.front().accuracy()));
+            assert(("Fused functions take x and y." && function.program().num_variables == 0u));
+
+            roots.push_back(graph.merge(function.program().code));
+            stats.nodes_before += function.optimization_stats().nodes_after;
+        }
+
+        compiled           = graph.to_fused_program(roots);
+        compiled.precision = functions.front().precision();
+        compiled.accuracy  = functions.front().accuracy();
+        stats.nodes_after  = count_nodes(compiled);
+    }
+
+    void FusedFunction::eval(double x, double y, std::span<double> out) const {
+        execute_fused(compiled.view(), x, y, out);
+    }
+
+    void FusedFunction::eval(float x, float y, std::span<float> out) const {
+        execute_fused(compiled.view(), x, y, out);
+    }
+
+    void FusedFunction::eval_batch(std::span<const double> xs,
+                                   std::span<const double> ys,
+                                   std::span<const std::span<double>> outs) const {
+        execute_fused_batch(compiled.view(), xs, ys, outs);
+    }
+
+    void FusedFunction::eval_batch(std::span<const float> xs,
+                                   std::span<const float> ys,
+                                   std::span<const std::span<float>> outs) const {
+        execute_fused_batch(compiled.view(), xs, ys, outs);
+    }
+} // namespace InputHandling::_Internal
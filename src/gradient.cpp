@@ -0,0 +1,215 @@
+#include "../include/math_parser/gradient.hpp"
+#include "../include/math_parser/kernels.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    // f(a) given f and f'(a) for a unary function.
+    Gradient chain(const Gradient &a, double value, double derivative) {
+        return {value, derivative * a.dx, derivative * a.dy};
+    }
+
+    // Partial derivative of a^b along one direction. Each term is skipped when its factor is zero, so constant
+    // exponents of negative bases do not pick up the NaN of log(a).
+    double pow_derivative(double a, double b, double value, double da, double db) {
+        double derivative = 0.;
+        if (da != 0.) { derivative += b * std::pow(a, b - 1.) * da; }
+        if (db != 0.) { derivative += value * std::log(a) * db; }
+        return derivative;
+    }
+
+    double smoothstep_derivative(double e1, double e2, double v, double de1, double de2, double dv) {
+        const double u = (v - e1) / (e2 - e1);
+        if ((u > 0. && u < 1.) == false) { return 0.; }
+
+        const double du = ((dv - de1) - u * (de2 - de1)) / (e2 - e1);
+        return 6. * u * (1. - u) * du;
+    }
+
+    Gradient run(std::span<const Instruction> code, Gradient *slots, Gradient *stack, double x, double y) {
+        Gradient *sp = stack;
+
+        for (const auto &ins : code) {
+            switch (ins.op) {
+            case OpCode::X: *sp++ = {x, 1., 0.}; continue;
+            case OpCode::Y: *sp++ = {y, 0., 1.}; continue;
+            case OpCode::Variable: *sp++ = ins.slot == 0u ? Gradient{x, 1., 0.} : Gradient{y, 0., 1.}; continue;
+            case OpCode::Constant: *sp++ = {ins.value, 0., 0.}; continue;
+            case OpCode::Store: slots[ins.slot] = sp[-1]; continue;
+            case OpCode::Load: *sp++ = slots[ins.slot]; continue;
+            default: break;
+            }
+
+            const auto num_args = arity(ins.op);
+            sp -= num_args;
+            const auto a = sp[0];
+            const auto b = num_args > 1u ? sp[1] : Gradient{};
+            const auto c = num_args > 2u ? sp[2] : Gradient{};
+            auto &r      = *sp++;
+
+            switch (ins.op) {
+            case OpCode::Add: r = {a.value + b.value, a.dx + b.dx, a.dy + b.dy}; break;
+            case OpCode::Sub: r = {a.value - b.value, a.dx - b.dx, a.dy - b.dy}; break;
+            case OpCode::Mul:
+                r = {a.value * b.value, a.dx * b.value + a.value * b.dx, a.dy * b.value + a.value * b.dy};
+                break;
+            case OpCode::Div: {
+                const double q = a.value / b.value;
+                r              = {q, (a.dx - q * b.dx) / b.value, (a.dy - q * b.dy) / b.value};
+                break;
+            }
+            case OpCode::Pow: {
+                const double v = std::pow(a.value, b.value);
+                r              = {v,
+                                  pow_derivative(a.value, b.value, v, a.dx, b.dx),
+                                  pow_derivative(a.value, b.value, v, a.dy, b.dy)};
+                break;
+            }
+            case OpCode::Neg: r = {-a.value, -a.dx, -a.dy}; break;
+
+            case OpCode::Sin: r = chain(a, std::sin(a.value), std::cos(a.value)); break;
+            case OpCode::Cos: r = chain(a, std::cos(a.value), -std::sin(a.value)); break;
+            case OpCode::Tan: {
+                const double v = std::tan(a.value);
+                r              = chain(a, v, 1. + v * v);
+                break;
+            }
+            case OpCode::Sec: {
+                const double v = Kernels::sec(a.value);
+                r              = chain(a, v, v * std::tan(a.value));
+                break;
+            }
+            case OpCode::Csc: {
+                const double v = Kernels::csc(a.value);
+                r              = chain(a, v, -v * Kernels::cot(a.value));
+                break;
+            }
+            case OpCode::Cot: {
+                const double v = Kernels::cot(a.value);
+                r              = chain(a, v, -(1. + v * v));
+                break;
+            }
+
+            case OpCode::Sinh: r = chain(a, std::sinh(a.value), std::cosh(a.value)); break;
+            case OpCode::Cosh: r = chain(a, std::cosh(a.value), std::sinh(a.value)); break;
+            case OpCode::Tanh: {
+                const double v = std::tanh(a.value);
+                r              = chain(a, v, 1. - v * v);
+                break;
+            }
+            case OpCode::Sech: {
+                const double v = Kernels::sech(a.value);
+                r              = chain(a, v, -v * std::tanh(a.value));
+                break;
+            }
+            case OpCode::Csch: {
+                const double v = Kernels::csch(a.value);
+                r              = chain(a, v, -v * Kernels::coth(a.value));
+                break;
+            }
+            case OpCode::Coth: {
+                const double v = Kernels::coth(a.value);
+                r              = chain(a, v, 1. - v * v);
+                break;
+            }
+
+            case OpCode::Asin: r = chain(a, std::asin(a.value), 1. / std::sqrt(1. - a.value * a.value)); break;
+            case OpCode::Acos: r = chain(a, std::acos(a.value), -1. / std::sqrt(1. - a.value * a.value)); break;
+            case OpCode::Atan: r = chain(a, std::atan(a.value), 1. / (1. + a.value * a.value)); break;
+
+            case OpCode::Asinh: r = chain(a, std::asinh(a.value), 1. / std::sqrt(a.value * a.value + 1.)); break;
+            case OpCode::Acosh: r = chain(a, std::acosh(a.value), 1. / std::sqrt(a.value * a.value - 1.)); break;
+            case OpCode::Atanh: r = chain(a, std::atanh(a.value), 1. / (1. - a.value * a.value)); break;
+
+            case OpCode::Ln: r = chain(a, std::log(a.value), 1. / a.value); break;
+            case OpCode::Log: r = chain(a, std::log10(a.value), 1. / (a.value * std::numbers::ln10)); break;
+            // At 0 the sign of the zero picks the side, so abs has derivative ±1 there like everywhere else.
+            case OpCode::Abs: r = chain(a, std::abs(a.value), std::copysign(1., a.value)); break;
+            case OpCode::Exp: {
+                const double v = std::exp(a.value);
+                r              = chain(a, v, v);
+                break;
+            }
+            case OpCode::Sign: r = chain(a, Kernels::sign(a.value), 0.); break;
+            case OpCode::Floor: r = chain(a, std::floor(a.value), 0.); break;
+            case OpCode::Ceil: r = chain(a, std::ceil(a.value), 0.); break;
+            case OpCode::Trunc: r = chain(a, std::trunc(a.value), 0.); break;
+            case OpCode::Fract: r = chain(a, Kernels::fract(a.value), 1.); break;
+
+            // Same selection as std::max and std::min, so the derivative follows the operand that was returned.
+            case OpCode::Max: r = a.value < b.value ? b : a; break;
+            case OpCode::Min: r = b.value < a.value ? b : a; break;
+            case OpCode::Step: r = {Kernels::step(a.value, b.value), 0., 0.}; break;
+
+            // Same selection as std::clamp.
+            case OpCode::Clamp: r = a.value < b.value ? b : c.value < a.value ? c : a; break;
+            case OpCode::Mix: {
+                const double t = c.value;
+                r              = {Kernels::mix(a.value, b.value, t),
+                                  a.dx * (1. - t) + b.dx * t + (b.value - a.value) * c.dx,
+                                  a.dy * (1. - t) + b.dy * t + (b.value - a.value) * c.dy};
+                break;
+            }
+            case OpCode::Smoothstep:
+                r = {Kernels::smoothstep(a.value, b.value, c.value),
+                     smoothstep_derivative(a.value, b.value, c.value, a.dx, b.dx, c.dx),
+                     smoothstep_derivative(a.value, b.value, c.value, a.dy, b.dy, c.dy)};
+                break;
+
+            case OpCode::Square: r = chain(a, Kernels::square(a.value), 2. * a.value); break;
+            case OpCode::Sqrt: {
+                const double v = Kernels::sqrt(a.value);
+                r              = chain(a, v, 0.5 / v);
+                break;
+            }
+            case OpCode::MulAdd:
+                r = {Kernels::mul_add(a.value, b.value, c.value),
+                     a.dx * b.value + a.value * b.dx + c.dx,
+                     a.dy * b.value + a.value * b.dy + c.dy};
+                break;
+
+            default: assert(("Opcode has no derivative." && false)); break;
+            }
+        }
+
+        return sp[-1];
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    Gradient execute_with_gradient(const ProgramView &program, double x, double y) {
+        assert(("Gradients are taken with respect to x and y." && program.num_variables <= 2u));
+        constexpr uint32_t inline_storage_size = 32u;
+
+        // Slots first, stack after them, as in execute().
+        Gradient inline_storage[inline_storage_size];
+        std::vector<Gradient> heap_storage;
+        Gradient *slots = inline_storage;
+        if (program.num_slots + program.stack_size > inline_storage_size) {
+            heap_storage.resize(program.num_slots + program.stack_size);
+            slots = heap_storage.data();
+        }
+
+        return run(program.code, slots, slots + program.num_slots, x, y);
+    }
+
+    void execute_batch_with_gradient(const ProgramView &program,
+                                     std::span<const double> xs,
+                                     std::span<const double> ys,
+                                     std::span<Gradient> out) {
+        assert(("Input and output spans must have the same length." && xs.size() == out.size()
+                && ys.size() == out.size()));
+        assert(("Gradients are taken with respect to x and y." && program.num_variables <= 2u));
+
+        std::vector<Gradient> storage(program.num_slots + program.stack_size);
+        Gradient *slots = storage.data();
+        Gradient *stack = slots + program.num_slots;
+
+        for (std::size_t i = 0u; i < out.size(); ++i) { out[i] = run(program.code, slots, stack, xs[i], ys[i]); }
+    }
+} // namespace InputHandling::_Internal
@@ -0,0 +1,360 @@
+#include "../include/math_parser/interval.hpp"
+#include "../include/math_parser/kernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    constexpr double pi       = std::numbers::pi;
+
+    // Outward rounding. Arithmetic is correctly rounded, so one ulp encloses the exact result. Library functions
+    // are not, and get a wider margin.
+    constexpr int arithmetic_ulps = 1;
+    constexpr int libm_ulps       = 4;
+
+    double down(double v, int ulps = arithmetic_ulps) {
+        for (int i = 0; i < ulps; ++i) { v = std::nextafter(v, -infinity); }
+        return v;
+    }
+    double up(double v, int ulps = arithmetic_ulps) {
+        for (int i = 0; i < ulps; ++i) { v = std::nextafter(v, infinity); }
+        return v;
+    }
+
+    // Indeterminate forms such as inf - inf only arise from unbounded operands, so they widen to the whole line.
+    Interval make(double lo, double hi) {
+        return {std::isnan(lo) ? -infinity : lo, std::isnan(hi) ? infinity : hi};
+    }
+
+    Interval hull(Interval a, Interval b) { return {std::min(a.lo, b.lo), std::max(a.hi, b.hi)}; }
+
+    Interval clip(Interval a, double lo, double hi) {
+        const Interval r{std::max(a.lo, lo), std::min(a.hi, hi)};
+        return r.is_empty() ? Interval::empty() : r;
+    }
+
+    // Smallest and largest absolute value in the interval.
+    double mignitude(Interval a) { return a.contains(0.) ? 0. : std::min(std::abs(a.lo), std::abs(a.hi)); }
+    double magnitude(Interval a) { return std::max(std::abs(a.lo), std::abs(a.hi)); }
+
+    template <typename F> Interval increasing(Interval a, F f) {
+        return make(down(f(a.lo), libm_ulps), up(f(a.hi), libm_ulps));
+    }
+    template <typename F> Interval decreasing(Interval a, F f) {
+        return make(down(f(a.hi), libm_ulps), up(f(a.lo), libm_ulps));
+    }
+
+    Interval add(Interval a, Interval b) { return make(down(a.lo + b.lo), up(a.hi + b.hi)); }
+    Interval sub(Interval a, Interval b) { return make(down(a.lo - b.hi), up(a.hi - b.lo)); }
+    Interval neg(Interval a) { return {-a.hi, -a.lo}; }
+
+    Interval mul(Interval a, Interval b) {
+        // 0 * inf is taken as 0: the zero bound is exact, so the product it stands for is 0.
+        const auto product = [](double u, double v) {
+            const double p = u * v;
+            return std::isnan(p) ? 0. : p;
+        };
+        const double p[] = {product(a.lo, b.lo), product(a.lo, b.hi), product(a.hi, b.lo), product(a.hi, b.hi)};
+        return make(down(*std::min_element(p, p + 4)), up(*std::max_element(p, p + 4)));
+    }
+
+    Interval reciprocal(Interval a) {
+        if (a.contains(0.)) { return Interval::entire(); }
+        return make(down(1. / a.hi), up(1. / a.lo));
+    }
+
+    Interval div(Interval a, Interval b) {
+        if (b.contains(0.)) { return Interval::entire(); }
+
+        // inf / inf has no meaningful value; the other quotients already span what it could stand for.
+        double lo = infinity, hi = -infinity;
+        for (const double u : {a.lo, a.hi}) {
+            for (const double v : {b.lo, b.hi}) {
+                const double q = u / v;
+                if (std::isnan(q)) { continue; }
+                lo = std::min(lo, q);
+                hi = std::max(hi, q);
+            }
+        }
+        return lo <= hi ? make(down(lo), up(hi)) : Interval::entire();
+    }
+
+    Interval pow(Interval a, Interval b) {
+        // Integer exponents are defined for negative bases and have simple monotonicity.
+        if (b.lo == b.hi && std::trunc(b.lo) == b.lo && std::abs(b.lo) < 0x1p53) {
+            const double n  = b.lo;
+            const bool even = std::fmod(n, 2.) == 0.;
+            if (n == 0.) { return {1., 1.}; }
+            if (a.contains(0.) && n < 0.) {
+                if (even == false) { return Interval::entire(); }
+                return make(down(std::min(std::pow(a.lo, n), std::pow(a.hi, n)), libm_ulps), infinity);
+            }
+            if (a.contains(0.) && even) { return make(0., up(std::pow(magnitude(a), n), libm_ulps)); }
+
+            const double u = std::pow(a.lo, n), v = std::pow(a.hi, n);
+            return make(down(std::min(u, v), libm_ulps), up(std::max(u, v), libm_ulps));
+        }
+
+        // Otherwise the base must be non-negative. There a^b is monotonic in each argument, so its extremes over
+        // the box are at the corners.
+        if (a.lo < 0.) {
+            // Integral exponents inside b would still reach negative bases.
+            if (std::floor(b.hi) >= std::ceil(b.lo)) { return Interval::entire(); }
+            a = clip(a, 0., infinity);
+            if (a.is_empty()) { return Interval::empty(); }
+        }
+
+        double lo = infinity, hi = -infinity;
+        for (const double u : {a.lo, a.hi}) {
+            for (const double v : {b.lo, b.hi}) {
+                const double p = std::pow(u, v);
+                lo             = std::min(lo, p);
+                hi             = std::max(hi, p);
+            }
+        }
+        return make(std::max(0., down(lo, libm_ulps)), up(hi, libm_ulps));
+    }
+
+    // Whether some phase + k * period, k integer, may lie in `a`. Errs towards true, which only loosens bounds.
+    bool may_contain_phase(Interval a, double phase, double period) {
+        const double margin = 1e-12 * (1. + magnitude(a));
+        const double k0     = std::floor((a.lo - phase) / period);
+        for (double k = k0 - 1.; k <= k0 + 2.; ++k) {
+            const double t = phase + k * period;
+            if (t >= a.lo - margin && t <= a.hi + margin) { return true; }
+        }
+        return false;
+    }
+
+    // Beyond this magnitude the spacing of doubles approaches the period and endpoints say nothing.
+    constexpr double max_periodic_argument = 0x1p50;
+
+    // Smooth periodic function with maxima at max_phase and minima at min_phase, both modulo 2 pi.
+    template <typename F> Interval periodic(Interval a, F f, double max_phase, double min_phase) {
+        if ((a.hi - a.lo < 2. * pi) == false || magnitude(a) > max_periodic_argument) { return {-1., 1.}; }
+
+        const double u = f(a.lo), v = f(a.hi);
+        Interval r{down(std::min(u, v), libm_ulps), up(std::max(u, v), libm_ulps)};
+        if (may_contain_phase(a, max_phase, 2. * pi)) { r.hi = 1.; }
+        if (may_contain_phase(a, min_phase, 2. * pi)) { r.lo = -1.; }
+        return {std::max(r.lo, -1.), std::min(r.hi, 1.)};
+    }
+
+    Interval sin(Interval a) {
+        return periodic(a, [](double v) { return std::sin(v); }, pi / 2., -pi / 2.);
+    }
+    Interval cos(Interval a) {
+        return periodic(a, [](double v) { return std::cos(v); }, 0., pi);
+    }
+    Interval tan(Interval a) {
+        if ((a.hi - a.lo < pi) == false || magnitude(a) > max_periodic_argument) { return Interval::entire(); }
+        if (may_contain_phase(a, pi / 2., pi)) { return Interval::entire(); }
+        return increasing(a, [](double v) { return std::tan(v); });
+    }
+
+    Interval cosh(Interval a) {
+        return make(std::max(1., down(std::cosh(mignitude(a)), libm_ulps)), up(std::cosh(magnitude(a)), libm_ulps));
+    }
+    Interval tanh(Interval a) {
+        const auto r = increasing(a, [](double v) { return std::tanh(v); });
+        return {std::max(r.lo, -1.), std::min(r.hi, 1.)};
+    }
+
+    Interval fract(Interval a) {
+        // fract(v) = v - trunc(v) is exact and increasing between consecutive integers, and (-1, 1) is one piece.
+        if (std::trunc(a.lo) == std::trunc(a.hi)) { return {Kernels::fract(a.lo), Kernels::fract(a.hi)}; }
+        return {a.lo < 0. ? -1. : 0., a.hi > 0. ? 1. : 0.};
+    }
+
+    Interval step(Interval edge, Interval v) {
+        if (v.hi < edge.lo) { return {0., 0.}; }
+        if (v.lo >= edge.hi) { return {1., 1.}; }
+        return {0., 1.};
+    }
+
+    Interval clamp(Interval v, Interval lo, Interval hi) {
+        // With lo <= hi clamp is increasing in every argument. Otherwise it returns one of its arguments.
+        if (lo.hi <= hi.lo) {
+            return {Kernels::clamp(v.lo, lo.lo, hi.lo), Kernels::clamp(v.hi, lo.hi, hi.hi)};
+        }
+        return hull(hull(v, lo), hi);
+    }
+
+    Interval mix(Interval a, Interval b, Interval t) {
+        return add(mul(a, sub({1., 1.}, t)), mul(b, t));
+    }
+
+    Interval smoothstep(Interval e1, Interval e2, Interval v) {
+        // t * t * (3 - 2t) is increasing on [0, 1], the range of the clamped ramp t.
+        const auto ramp = div(sub(v, e1), sub(e2, e1));
+        const double lo = std::clamp(ramp.lo, 0., 1.), hi = std::clamp(ramp.hi, 0., 1.);
+        const auto s    = [](double t) { return t * t * (3. - 2. * t); };
+        return {std::max(0., down(s(lo), libm_ulps)), std::min(1., up(s(hi), libm_ulps))};
+    }
+
+    Interval run(std::span<const Instruction> code, Interval *slots, Interval *stack, Interval x, Interval y) {
+        Interval *sp = stack;
+
+        for (const auto &ins : code) {
+            switch (ins.op) {
+            case OpCode::X: *sp++ = x; continue;
+            case OpCode::Y: *sp++ = y; continue;
+            case OpCode::Variable: *sp++ = ins.slot == 0u ? x : y; continue;
+            case OpCode::Constant: *sp++ = {ins.value, ins.value}; continue;
+            case OpCode::Store: slots[ins.slot] = sp[-1]; continue;
+            case OpCode::Load: *sp++ = slots[ins.slot]; continue;
+            default: break;
+            }
+
+            const auto num_args = arity(ins.op);
+            sp -= num_args;
+            const auto a = sp[0];
+            const auto b = num_args > 1u ? sp[1] : Interval{};
+            const auto c = num_args > 2u ? sp[2] : Interval{};
+            auto &r      = *sp++;
+
+            if (a.is_empty() || b.is_empty() || c.is_empty()) {
+                r = Interval::empty();
+                continue;
+            }
+
+            switch (ins.op) {
+            case OpCode::Add: r = add(a, b); break;
+            case OpCode::Sub: r = sub(a, b); break;
+            case OpCode::Mul: r = mul(a, b); break;
+            case OpCode::Div: r = div(a, b); break;
+            case OpCode::Pow: r = pow(a, b); break;
+            case OpCode::Neg: r = neg(a); break;
+
+            case OpCode::Sin: r = sin(a); break;
+            case OpCode::Cos: r = cos(a); break;
+            case OpCode::Tan: r = tan(a); break;
+            case OpCode::Sec: r = reciprocal(cos(a)); break;
+            case OpCode::Csc: r = reciprocal(sin(a)); break;
+            case OpCode::Cot: r = reciprocal(tan(a)); break;
+
+            case OpCode::Sinh: r = increasing(a, [](double v) { return std::sinh(v); }); break;
+            case OpCode::Cosh: r = cosh(a); break;
+            case OpCode::Tanh: r = tanh(a); break;
+            case OpCode::Sech: r = reciprocal(cosh(a)); break;
+            case OpCode::Csch: r = reciprocal(increasing(a, [](double v) { return std::sinh(v); })); break;
+            case OpCode::Coth: r = reciprocal(tanh(a)); break;
+
+            case OpCode::Asin: {
+                const auto d = clip(a, -1., 1.);
+                r = d.is_empty() ? d : increasing(d, [](double v) { return std::asin(v); });
+                break;
+            }
+            case OpCode::Acos: {
+                const auto d = clip(a, -1., 1.);
+                r = d.is_empty() ? d : decreasing(d, [](double v) { return std::acos(v); });
+                break;
+            }
+            case OpCode::Atan: r = increasing(a, [](double v) { return std::atan(v); }); break;
+
+            case OpCode::Asinh: r = increasing(a, [](double v) { return std::asinh(v); }); break;
+            case OpCode::Acosh: {
+                const auto d = clip(a, 1., infinity);
+                r = d.is_empty() ? d : increasing(d, [](double v) { return std::acosh(v); });
+                break;
+            }
+            case OpCode::Atanh: {
+                const auto d = clip(a, -1., 1.);
+                r = d.is_empty() ? d : increasing(d, [](double v) { return std::atanh(v); });
+                break;
+            }
+
+            case OpCode::Ln: {
+                const auto d = clip(a, 0., infinity);
+                r = d.is_empty() ? d : increasing(d, [](double v) { return std::log(v); });
+                break;
+            }
+            case OpCode::Log: {
+                const auto d = clip(a, 0., infinity);
+                r = d.is_empty() ? d : increasing(d, [](double v) { return std::log10(v); });
+                break;
+            }
+            case OpCode::Abs: r = {mignitude(a), magnitude(a)}; break;
+            case OpCode::Exp: {
+                const auto e = increasing(a, [](double v) { return std::exp(v); });
+                r            = {std::max(0., e.lo), e.hi};
+                break;
+            }
+            // Piecewise constant and non-decreasing, so the endpoints are exact bounds.
+            case OpCode::Sign: r = {Kernels::sign(a.lo), Kernels::sign(a.hi)}; break;
+            case OpCode::Floor: r = {std::floor(a.lo), std::floor(a.hi)}; break;
+            case OpCode::Ceil: r = {std::ceil(a.lo), std::ceil(a.hi)}; break;
+            case OpCode::Trunc: r = {std::trunc(a.lo), std::trunc(a.hi)}; break;
+            case OpCode::Fract: r = fract(a); break;
+
+            case OpCode::Max: r = {std::max(a.lo, b.lo), std::max(a.hi, b.hi)}; break;
+            case OpCode::Min: r = {std::min(a.lo, b.lo), std::min(a.hi, b.hi)}; break;
+            case OpCode::Step: r = step(a, b); break;
+
+            case OpCode::Clamp: r = clamp(a, b, c); break;
+            case OpCode::Mix: r = mix(a, b, c); break;
+            case OpCode::Smoothstep: r = smoothstep(a, b, c); break;
+
+            case OpCode::Square: r = {down(mignitude(a) * mignitude(a)), up(magnitude(a) * magnitude(a))}; break;
+            case OpCode::Sqrt: r = pow(a, {0.5, 0.5}); break;
+            case OpCode::MulAdd: r = add(mul(a, b), c); break;
+
+            default: assert(("Opcode has no interval extension." && false)); break;
+            }
+        }
+
+        return sp[-1];
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    Interval execute_interval(const ProgramView &program, Interval x, Interval y) {
+        assert(("Intervals are taken over boxes in x and y." && program.num_variables <= 2u));
+        constexpr uint32_t inline_storage_size = 32u;
+
+        // Slots first, stack after them, as in execute().
+        Interval inline_storage[inline_storage_size];
+        std::vector<Interval> heap_storage;
+        Interval *slots = inline_storage;
+        if (program.num_slots + program.stack_size > inline_storage_size) {
+            heap_storage.resize(program.num_slots + program.stack_size);
+            slots = heap_storage.data();
+        }
+
+        return run(program.code, slots, slots + program.num_slots, x, y);
+    }
+
+    std::vector<Box> implicit_curve_cells(const ProgramView &program, const Box &region, uint32_t max_depth) {
+        struct Cell {
+            Box box;
+            uint32_t depth;
+        };
+
+        std::vector<Box> cells;
+        std::vector<Cell> pending{{region, 0u}};
+        while (pending.empty() == false) {
+            const auto [box, depth] = pending.back();
+            pending.pop_back();
+
+            if (execute_interval(program, box.x, box.y).contains(0.) == false) { continue; }
+            if (depth == max_depth) {
+                cells.push_back(box);
+                continue;
+            }
+
+            // The halves share their midpoint, so together they cover the box.
+            const double xm = box.x.lo + (box.x.hi - box.x.lo) / 2.;
+            const double ym = box.y.lo + (box.y.hi - box.y.lo) / 2.;
+            pending.push_back({{{box.x.lo, xm}, {box.y.lo, ym}}, depth + 1u});
+            pending.push_back({{{xm, box.x.hi}, {box.y.lo, ym}}, depth + 1u});
+            pending.push_back({{{box.x.lo, xm}, {ym, box.y.hi}}, depth + 1u});
+            pending.push_back({{{xm, box.x.hi}, {ym, box.y.hi}}, depth + 1u});
+        }
+        return cells;
+    }
+} // namespace InputHandling::_Internal
@@ -0,0 +1,433 @@
+#include "../include/math_parser/jit.hpp"
+#include "../include/math_parser/fast_math.hpp"
+#include "../include/math_parser/kernels.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__unix__)
+#define MATH_PARSER_HAS_JIT 1
+#include <sys/mman.h>
+#endif
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    // Standard library functions may not have their address taken, so calls go through these.
+    double call_pow(double a, double b) { return std::pow(a, b); }
+    double call_sin(double v) { return std::sin(v); }
+    double call_cos(double v) { return std::cos(v); }
+    double call_tan(double v) { return std::tan(v); }
+    double call_sinh(double v) { return std::sinh(v); }
+    double call_cosh(double v) { return std::cosh(v); }
+    double call_tanh(double v) { return std::tanh(v); }
+    double call_asin(double v) { return std::asin(v); }
+    double call_acos(double v) { return std::acos(v); }
+    double call_atan(double v) { return std::atan(v); }
+    double call_asinh(double v) { return std::asinh(v); }
+    double call_acosh(double v) { return std::acosh(v); }
+    double call_atanh(double v) { return std::atanh(v); }
+    double call_ln(double v) { return std::log(v); }
+    double call_log(double v) { return std::log10(v); }
+    double call_abs(double v) { return std::abs(v); }
+    double call_exp(double v) { return std::exp(v); }
+    double call_floor(double v) { return std::floor(v); }
+    double call_ceil(double v) { return std::ceil(v); }
+    double call_trunc(double v) { return std::trunc(v); }
+
+    // The approximation of Accuracy::Fast an opcode calls, or nullptr when it always calls libm or the kernels.
+    const void *fast_callee_of(OpCode op) {
+        using Unary = double (*)(double);
+        using namespace FastMath;
+
+        switch (op) {
+        case OpCode::Sin: return reinterpret_cast<const void *>(Unary{evaluate<Sin, double>});
+        case OpCode::Cos: return reinterpret_cast<const void *>(Unary{evaluate<Cos, double>});
+        case OpCode::Tan: return reinterpret_cast<const void *>(Unary{evaluate<Tan, double>});
+        case OpCode::Sec: return reinterpret_cast<const void *>(Unary{evaluate<Sec, double>});
+        case OpCode::Csc: return reinterpret_cast<const void *>(Unary{evaluate<Csc, double>});
+        case OpCode::Cot: return reinterpret_cast<const void *>(Unary{evaluate<Cot, double>});
+        case OpCode::Sinh: return reinterpret_cast<const void *>(Unary{evaluate<Sinh, double>});
+        case OpCode::Cosh: return reinterpret_cast<const void *>(Unary{evaluate<Cosh, double>});
+        case OpCode::Tanh: return reinterpret_cast<const void *>(Unary{evaluate<Tanh, double>});
+        case OpCode::Sech: return reinterpret_cast<const void *>(Unary{evaluate<Sech, double>});
+        case OpCode::Csch: return reinterpret_cast<const void *>(Unary{evaluate<Csch, double>});
+        case OpCode::Coth: return reinterpret_cast<const void *>(Unary{evaluate<Coth, double>});
+        case OpCode::Ln: return reinterpret_cast<const void *>(Unary{evaluate<Ln, double>});
+        case OpCode::Log: return reinterpret_cast<const void *>(Unary{evaluate<Log, double>});
+        case OpCode::Exp: return reinterpret_cast<const void *>(Unary{evaluate<Exp, double>});
+        default: return nullptr;
+        }
+    }
+
+    // Address of the kernel an opcode calls, or nullptr when it is emitted inline.
+    const void *callee_of(OpCode op, Accuracy accuracy) {
+        using Unary   = double (*)(double);
+        using Binary  = double (*)(double, double);
+        using Ternary = double (*)(double, double, double);
+
+        if (const auto fast = fast_callee_of(op); fast && accuracy == Accuracy::Fast) { return fast; }
+
+        switch (op) {
+        case OpCode::Pow: return reinterpret_cast<const void *>(Binary{call_pow});
+        case OpCode::Sin: return reinterpret_cast<const void *>(Unary{call_sin});
+        case OpCode::Cos: return reinterpret_cast<const void *>(Unary{call_cos});
+        case OpCode::Tan: return reinterpret_cast<const void *>(Unary{call_tan});
+        case OpCode::Sec: return reinterpret_cast<const void *>(Unary{Kernels::sec});
+        case OpCode::Csc: return reinterpret_cast<const void *>(Unary{Kernels::csc});
+        case OpCode::Cot: return reinterpret_cast<const void *>(Unary{Kernels::cot});
+        case OpCode::Sinh: return reinterpret_cast<const void *>(Unary{call_sinh});
+        case OpCode::Cosh: return reinterpret_cast<const void *>(Unary{call_cosh});
+        case OpCode::Tanh: return reinterpret_cast<const void *>(Unary{call_tanh});
+        case OpCode::Sech: return reinterpret_cast<const void *>(Unary{Kernels::sech});
+        case OpCode::Csch: return reinterpret_cast<const void *>(Unary{Kernels::csch});
+        case OpCode::Coth: return reinterpret_cast<const void *>(Unary{Kernels::coth});
+        case OpCode::Asin: return reinterpret_cast<const void *>(Unary{call_asin});
+        case OpCode::Acos: return reinterpret_cast<const void *>(Unary{call_acos});
+        case OpCode::Atan: return reinterpret_cast<const void *>(Unary{call_atan});
+        case OpCode::Asinh: return reinterpret_cast<const void *>(Unary{call_asinh});
+        case OpCode::Acosh: return reinterpret_cast<const void *>(Unary{call_acosh});
+        case OpCode::Atanh: return reinterpret_cast<const void *>(Unary{call_atanh});
+        case OpCode::Ln: return reinterpret_cast<const void *>(Unary{call_ln});
+        case OpCode::Log: return reinterpret_cast<const void *>(Unary{call_log});
+        case OpCode::Abs: return reinterpret_cast<const void *>(Unary{call_abs});
+        case OpCode::Exp: return reinterpret_cast<const void *>(Unary{call_exp});
+        case OpCode::Sign: return reinterpret_cast<const void *>(Unary{Kernels::sign});
+        case OpCode::Floor: return reinterpret_cast<const void *>(Unary{call_floor});
+        case OpCode::Ceil: return reinterpret_cast<const void *>(Unary{call_ceil});
+        case OpCode::Trunc: return reinterpret_cast<const void *>(Unary{call_trunc});
+        case OpCode::Fract: return reinterpret_cast<const void *>(Unary{Kernels::fract});
+        case OpCode::Step: return reinterpret_cast<const void *>(Binary{Kernels::step});
+        case OpCode::Clamp: return reinterpret_cast<const void *>(Ternary{Kernels::clamp});
+        case OpCode::Mix: return reinterpret_cast<const void *>(Ternary{Kernels::mix});
+        case OpCode::Smoothstep: return reinterpret_cast<const void *>(Ternary{Kernels::smoothstep});
+        case OpCode::Square: return reinterpret_cast<const void *>(Unary{Kernels::square});
+        case OpCode::Sqrt: return reinterpret_cast<const void *>(Unary{Kernels::sqrt});
+        case OpCode::MulAdd: return reinterpret_cast<const void *>(Ternary{Kernels::mul_add});
+        default: return nullptr;
+        }
+    }
+
+    // Minimal x86-64 encoder for the handful of instruction forms the code generator needs. Memory operands are
+    // all [rbp + disp32].
+    struct Assembler {
+        std::vector<uint8_t> bytes;
+
+        void emit(std::initializer_list<uint8_t> b) { bytes.insert(bytes.end(), b); }
+        void emit32(int32_t v) {
+            for (int i = 0; i < 4; ++i) { bytes.push_back(static_cast<uint8_t>(static_cast<uint32_t>(v) >> (8 * i))); }
+        }
+        void emit64(uint64_t v) {
+            for (int i = 0; i < 8; ++i) { bytes.push_back(static_cast<uint8_t>(v >> (8 * i))); }
+        }
+        std::size_t size() const { return bytes.size(); }
+        void patch32(std::size_t at, int32_t v) {
+            for (int i = 0; i < 4; ++i) { bytes[at + i] = static_cast<uint8_t>(static_cast<uint32_t>(v) >> (8 * i)); }
+        }
+
+        // <op>sd xmm, [rbp + disp]
+        void sse_rbp(uint8_t opcode, uint8_t xmm, int32_t disp) {
+            emit({0xF2, 0x0F, opcode, static_cast<uint8_t>(0x85 | (xmm << 3))});
+            emit32(disp);
+        }
+        void movsd_load(uint8_t xmm, int32_t disp) { sse_rbp(0x10, xmm, disp); }
+        void movsd_store(int32_t disp, uint8_t xmm) { sse_rbp(0x11, xmm, disp); }
+
+        void mov_rax_from(int32_t disp) {
+            emit({0x48, 0x8B, 0x85});
+            emit32(disp);
+        }
+        void mov_rax_to(int32_t disp) {
+            emit({0x48, 0x89, 0x85});
+            emit32(disp);
+        }
+        void mov_rax_imm(uint64_t v) {
+            emit({0x48, 0xB8});
+            emit64(v);
+        }
+    };
+
+    // The packed forms (addpd, ...) share these opcodes, with a 0x66 prefix instead of 0xF2.
+    constexpr uint8_t addsd = 0x58, mulsd = 0x59, subsd = 0x5C, minsd = 0x5D, divsd = 0x5E, maxsd = 0x5F;
+
+    // double f(double x, double y). Frame: x at [rbp-8], y at [rbp-16], then the evaluation stack, then the slots.
+    void emit_scalar(Assembler &a, const Program &program) {
+        const auto stack_at = [](uint32_t i) { return -16 - 8 * static_cast<int32_t>(i + 1u); };
+        const auto slot_at  = [&](uint32_t i) { return stack_at(program.stack_size + i); };
+        const auto frame    = (16u + 8u * (program.stack_size + program.num_slots) + 15u) & ~15u;
+
+        a.emit({0x55});             // push rbp
+        a.emit({0x48, 0x89, 0xE5}); // mov rbp, rsp
+        a.emit({0x48, 0x81, 0xEC}); // sub rsp, frame
+        a.emit32(static_cast<int32_t>(frame));
+        a.movsd_store(-8, 0);
+        a.movsd_store(-16, 1);
+
+        uint32_t sp = 0u; // Number of values on the evaluation stack.
+        for (const auto &ins : program.code) {
+            switch (ins.op) {
+            case OpCode::X: a.mov_rax_from(-8), a.mov_rax_to(stack_at(sp++)); continue;
+            case OpCode::Y: a.mov_rax_from(-16), a.mov_rax_to(stack_at(sp++)); continue;
+            case OpCode::Constant: {
+                uint64_t bits;
+                std::memcpy(&bits, &ins.value, sizeof bits);
+                a.mov_rax_imm(bits), a.mov_rax_to(stack_at(sp++));
+                continue;
+            }
+            case OpCode::Store: a.mov_rax_from(stack_at(sp - 1u)), a.mov_rax_to(slot_at(ins.slot)); continue;
+            case OpCode::Load: a.mov_rax_from(slot_at(ins.slot)), a.mov_rax_to(stack_at(sp++)); continue;
+
+            case OpCode::Add:
+            case OpCode::Sub:
+            case OpCode::Mul:
+            case OpCode::Div: {
+                const uint8_t opcode = ins.op == OpCode::Add   ? addsd
+                                       : ins.op == OpCode::Sub ? subsd
+                                       : ins.op == OpCode::Mul ? mulsd
+                                                               : divsd;
+                --sp;
+                a.movsd_load(0, stack_at(sp - 1u));
+                a.sse_rbp(opcode, 0, stack_at(sp));
+                a.movsd_store(stack_at(sp - 1u), 0);
+                continue;
+            }
+            // Kernels::max(a, b) is a < b ? b : a, which is maxsd with b as the destination; min likewise.
+            case OpCode::Max:
+            case OpCode::Min:
+                --sp;
+                a.movsd_load(0, stack_at(sp));
+                a.sse_rbp(ins.op == OpCode::Max ? maxsd : minsd, 0, stack_at(sp - 1u));
+                a.movsd_store(stack_at(sp - 1u), 0);
+                continue;
+            case OpCode::Neg:
+                a.movsd_load(0, stack_at(sp - 1u));
+                a.mov_rax_imm(0x8000000000000000ull);
+                a.emit({0x66, 0x48, 0x0F, 0x6E, 0xC8}); // movq xmm1, rax
+                a.emit({0x66, 0x0F, 0x57, 0xC1});       // xorpd xmm0, xmm1
+                a.movsd_store(stack_at(sp - 1u), 0);
+                continue;
+            default: break;
+            }
+
+            const auto num_args = arity(ins.op);
+            sp -= num_args;
+            for (uint32_t i = 0u; i < num_args; ++i) { a.movsd_load(static_cast<uint8_t>(i), stack_at(sp + i)); }
+            a.mov_rax_imm(reinterpret_cast<uint64_t>(callee_of(ins.op, program.accuracy)));
+            a.emit({0xFF, 0xD0}); // call rax
+            a.movsd_store(stack_at(sp++), 0);
+        }
+
+        a.movsd_load(0, stack_at(0u));
+        a.emit({0xC9, 0xC3}); // leave; ret
+    }
+
+    // <op>pd xmm, [rbp + disp], for the packed forms, whose memory operands must be 16-byte aligned.
+    void sse_packed_rbp(Assembler &a, uint8_t opcode, uint8_t xmm, int32_t disp) {
+        a.emit({0x66, 0x0F, opcode, static_cast<uint8_t>(0x85 | (xmm << 3))});
+        a.emit32(disp);
+    }
+    void movapd_load(Assembler &a, uint8_t xmm, int32_t disp) { sse_packed_rbp(a, 0x28, xmm, disp); }
+    void movapd_store(Assembler &a, int32_t disp, uint8_t xmm) { sse_packed_rbp(a, 0x29, xmm, disp); }
+
+    // void f(const double *xs, const double *ys, double *out, size_t n). Points are evaluated two at a time in
+    // the lanes of SSE2 registers: arithmetic, negation, min and max with the packed forms of the scalar entry's
+    // instructions, calls once per lane into the same kernels. An odd last point goes through the scalar entry.
+    //
+    // Frame: rbx and r12-r15 below rbp, then 16-byte aligned pairs: x, y, the evaluation stack and the slots.
+    void emit_batch(Assembler &a, const Program &program, std::size_t scalar_offset) {
+        const auto pair_at = [](uint32_t i) { return -48 - 16 * static_cast<int32_t>(i + 1u); };
+        const auto x_at = pair_at(0u), y_at = pair_at(1u);
+        const auto stack_at = [&](uint32_t i) { return pair_at(2u + i); };
+        const auto slot_at  = [&](uint32_t i) { return stack_at(program.stack_size + i); };
+        // rbp is 16-byte aligned after the push, and so is rsp once the five registers and this are pushed.
+        const auto frame = 8u + 16u * (2u + program.stack_size + program.num_slots);
+
+        a.emit({0x55});                                                 // push rbp
+        a.emit({0x48, 0x89, 0xE5});                                     // mov rbp, rsp
+        a.emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbx, r12-r15
+        a.emit({0x48, 0x81, 0xEC});                                     // sub rsp, frame
+        a.emit32(static_cast<int32_t>(frame));
+        a.emit({0x49, 0x89, 0xFC}); // mov r12, rdi
+        a.emit({0x49, 0x89, 0xF5}); // mov r13, rsi
+        a.emit({0x49, 0x89, 0xD6}); // mov r14, rdx
+        a.emit({0x49, 0x89, 0xCF}); // mov r15, rcx
+        a.emit({0x31, 0xDB});       // xor ebx, ebx
+
+        const auto pairs = a.size();
+        a.emit({0x48, 0x8D, 0x43, 0x02}); // lea rax, [rbx + 2]
+        a.emit({0x4C, 0x39, 0xF8});       // cmp rax, r15
+        a.emit({0x0F, 0x87});             // ja tail
+        const auto to_tail = a.size();
+        a.emit32(0);
+
+        a.emit({0x66, 0x41, 0x0F, 0x10, 0x04, 0xDC});       // movupd xmm0, [r12 + rbx*8]
+        movapd_store(a, x_at, 0);
+        a.emit({0x66, 0x41, 0x0F, 0x10, 0x44, 0xDD, 0x00}); // movupd xmm0, [r13 + rbx*8]
+        movapd_store(a, y_at, 0);
+
+        uint32_t sp = 0u;
+        const auto copy = [&](int32_t to, int32_t from) { movapd_load(a, 0, from), movapd_store(a, to, 0); };
+        for (const auto &ins : program.code) {
+            switch (ins.op) {
+            case OpCode::X: copy(stack_at(sp++), x_at); continue;
+            case OpCode::Y: copy(stack_at(sp++), y_at); continue;
+            case OpCode::Constant: {
+                uint64_t bits;
+                std::memcpy(&bits, &ins.value, sizeof bits);
+                // Broadcast in a register, for the same reason as the lanes of calls below.
+                a.mov_rax_imm(bits);
+                a.emit({0x66, 0x48, 0x0F, 0x6E, 0xC0}); // movq xmm0, rax
+                a.emit({0x66, 0x0F, 0x14, 0xC0});       // unpcklpd xmm0, xmm0
+                movapd_store(a, stack_at(sp++), 0);
+                continue;
+            }
+            case OpCode::Store: copy(slot_at(ins.slot), stack_at(sp - 1u)); continue;
+            case OpCode::Load: copy(stack_at(sp++), slot_at(ins.slot)); continue;
+
+            case OpCode::Add:
+            case OpCode::Sub:
+            case OpCode::Mul:
+            case OpCode::Div: {
+                const uint8_t opcode = ins.op == OpCode::Add   ? addsd
+                                       : ins.op == OpCode::Sub ? subsd
+                                       : ins.op == OpCode::Mul ? mulsd
+                                                               : divsd;
+                --sp;
+                movapd_load(a, 0, stack_at(sp - 1u));
+                sse_packed_rbp(a, opcode, 0, stack_at(sp));
+                movapd_store(a, stack_at(sp - 1u), 0);
+                continue;
+            }
+            case OpCode::Max:
+            case OpCode::Min:
+                --sp;
+                movapd_load(a, 0, stack_at(sp));
+                sse_packed_rbp(a, ins.op == OpCode::Max ? maxsd : minsd, 0, stack_at(sp - 1u));
+                movapd_store(a, stack_at(sp - 1u), 0);
+                continue;
+            case OpCode::Neg:
+                movapd_load(a, 0, stack_at(sp - 1u));
+                a.mov_rax_imm(0x8000000000000000ull);
+                a.emit({0x66, 0x48, 0x0F, 0x6E, 0xC8}); // movq xmm1, rax
+                a.emit({0x66, 0x0F, 0x14, 0xC9});       // unpcklpd xmm1, xmm1
+                a.emit({0x66, 0x0F, 0x57, 0xC1});       // xorpd xmm0, xmm1
+                movapd_store(a, stack_at(sp - 1u), 0);
+                continue;
+            default: break;
+            }
+
+            const auto num_args = arity(ins.op);
+            sp -= num_args;
+            for (int32_t lane = 0; lane < 16; lane += 8) {
+                for (uint32_t i = 0u; i < num_args; ++i) {
+                    a.movsd_load(static_cast<uint8_t>(i), stack_at(sp + i) + lane);
+                }
+                a.mov_rax_imm(reinterpret_cast<uint64_t>(callee_of(ins.op, program.accuracy)));
+                a.emit({0xFF, 0xD0}); // call rax
+                if (lane == 0) { a.movsd_store(stack_at(sp), 0); }
+            }
+            // The lanes are joined in a register, as a 16-byte load of two 8-byte stores would stall.
+            a.movsd_load(1, stack_at(sp));
+            a.emit({0x66, 0x0F, 0x14, 0xC8}); // unpcklpd xmm1, xmm0
+            movapd_store(a, stack_at(sp++), 1);
+        }
+
+        movapd_load(a, 0, stack_at(0u));
+        a.emit({0x66, 0x41, 0x0F, 0x11, 0x04, 0xDE}); // movupd [r14 + rbx*8], xmm0
+        a.emit({0x48, 0x83, 0xC3, 0x02});             // add rbx, 2
+        a.emit({0xE9});                               // jmp pairs
+        a.emit32(static_cast<int32_t>(pairs) - static_cast<int32_t>(a.size() + 4u));
+
+        a.patch32(to_tail, static_cast<int32_t>(a.size() - (to_tail + 4u)));
+        a.emit({0x4C, 0x39, 0xFB}); // cmp rbx, r15
+        a.emit({0x0F, 0x83});       // jae done
+        const auto to_done = a.size();
+        a.emit32(0);
+        a.emit({0xF2, 0x41, 0x0F, 0x10, 0x04, 0xDC});       // movsd xmm0, [r12 + rbx*8]
+        a.emit({0xF2, 0x41, 0x0F, 0x10, 0x4C, 0xDD, 0x00}); // movsd xmm1, [r13 + rbx*8]
+        a.emit({0xE8});                                     // call scalar entry
+        a.emit32(static_cast<int32_t>(scalar_offset) - static_cast<int32_t>(a.size() + 4u));
+        a.emit({0xF2, 0x41, 0x0F, 0x11, 0x04, 0xDE}); // movsd [r14 + rbx*8], xmm0
+
+        a.patch32(to_done, static_cast<int32_t>(a.size() - (to_done + 4u)));
+        a.emit({0x48, 0x8D, 0x65, 0xD8});                               // lea rsp, [rbp - 40]
+        a.emit({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B}); // pop r15-r12, rbx
+        a.emit({0x5D, 0xC3});                                           // pop rbp; ret
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    JitFunction::JitFunction(const ParsedFunction &function) : program{function.program()} {
+#if defined(MATH_PARSER_HAS_JIT)
+        // The generated code works in double only, on x and y.
+        if (program.precision != Precision::Double || program.num_variables > 0u) { return; }
+
+        Assembler a;
+        emit_scalar(a, program);
+        const auto batch_offset = a.size();
+        emit_batch(a, program, 0u);
+
+        void *memory = mmap(nullptr, a.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) { return; }
+
+        std::memcpy(memory, a.bytes.data(), a.size());
+        if (mprotect(memory, a.size(), PROT_READ | PROT_EXEC) != 0) {
+            munmap(memory, a.size());
+            return;
+        }
+
+        code         = memory;
+        code_size    = a.size();
+        scalar_entry = reinterpret_cast<ScalarEntry>(code);
+        batch_entry  = reinterpret_cast<BatchEntry>(static_cast<uint8_t *>(code) + batch_offset);
+#endif
+    }
+
+    JitFunction::~JitFunction() { release(); }
+
+    JitFunction::JitFunction(JitFunction &&other) noexcept
+        : program{std::move(other.program)}, code{std::exchange(other.code, nullptr)},
+          code_size{std::exchange(other.code_size, 0u)}, scalar_entry{std::exchange(other.scalar_entry, nullptr)},
+          batch_entry{std::exchange(other.batch_entry, nullptr)} {}
+
+    JitFunction &JitFunction::operator=(JitFunction &&other) noexcept {
+        if (this != &other) {
+            release();
+            program      = std::move(other.program);
+            code         = std::exchange(other.code, nullptr);
+            code_size    = std::exchange(other.code_size, 0u);
+            scalar_entry = std::exchange(other.scalar_entry, nullptr);
+            batch_entry  = std::exchange(other.batch_entry, nullptr);
+        }
+        return *this;
+    }
+
+    double JitFunction::eval(double x, double y) const {
+        return scalar_entry ? scalar_entry(x, y) : execute(program.view(), x, y);
+    }
+
+    void JitFunction::eval_batch(std::span<const double> xs, std::span<const double> ys, std::span<double> out) const {
+        assert(("Input and output spans must have the same length." && xs.size() == out.size()
+                && ys.size() == out.size()));
+
+        if (batch_entry) {
+            batch_entry(xs.data(), ys.data(), out.data(), out.size());
+        } else {
+            execute_batch(program.view(), xs, ys, out);
+        }
+    }
+
+    void JitFunction::release() {
+#if defined(MATH_PARSER_HAS_JIT)
+        if (code) { munmap(code, code_size); }
+#endif
+        code         = nullptr;
+        code_size    = 0u;
+        scalar_entry = nullptr;
+        batch_entry  = nullptr;
+    }
+} // namespace InputHandling::_Internal
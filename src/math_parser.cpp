@@ -1,283 +1,218 @@
 #include "../include/math_parser/math_parser.hpp"
 #include "../include/math_parser/tokens.hpp"
-#include "../include/math_parser/token_evaluators.hpp"
-
-namespace InputHandling {
-    namespace _Internal {
-
-        template <typename T> inline PToken make_ptoken(T &&t) requires std::is_base_of_v<Token, T> {
-            return std::make_shared<T>(std::move(t));
-        }
-
-        ParsedFunction::ParsedFunction(std::queue<PToken> tokens) {
-            std::stack<PTokenEvaluator> s;
-            TokenEvaluatorFactory token_eval_factory;
-
-            while (tokens.empty() == false) {
-                auto token = tokens.front();
-                tokens.pop();
+#include "../include/math_parser/keywords.hpp"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    // Body of both eval_grid overloads. The coordinates are computed in double and then rounded to T.
+    template <typename T>
+    void sample_grid(const ParsedFunction &function,
+                     double x0,
+                     double x1,
+                     std::size_t nx,
+                     double y0,
+                     double y1,
+                     std::size_t ny,
+                     std::span<T> out,
+                     ThreadPool &pool) {
+        assert(("Output span must hold nx * ny values." && out.size() == nx * ny));
+        if (nx == 0u || ny == 0u) { return; }
+
+        // A tile is a contiguous run of the output: a band of whole rows, or a piece of one row when rows are
+        // wider than a tile. Its inputs and output then stay within L2 while it is evaluated.
+        constexpr std::size_t tile_points = 32u * batch_block_size;
+        const std::size_t tile_rows       = std::max<std::size_t>(1u, tile_points / nx);
+        const std::size_t tiles_per_row   = (nx + tile_points - 1u) / tile_points;
+        const std::size_t num_tiles =
+            tiles_per_row > 1u ? ny * tiles_per_row : (ny + tile_rows - 1u) / tile_rows;
+
+        const double dx = nx > 1u ? (x1 - x0) / static_cast<double>(nx - 1u) : 0.;
+        const double dy = ny > 1u ? (y1 - y0) / static_cast<double>(ny - 1u) : 0.;
+
+        pool.parallel_for(num_tiles, [&](std::size_t tile) {
+            std::size_t row, col, rows, cols;
+            if (tiles_per_row > 1u) {
+                row  = tile / tiles_per_row;
+                col  = (tile % tiles_per_row) * tile_points;
+                rows = 1u;
+                cols = std::min(tile_points, nx - col);
+            } else {
+                row  = tile * tile_rows;
+                col  = 0u;
+                rows = std::min(tile_rows, ny - row);
+                cols = nx;
+            }
 
-                auto newtoken = token_eval_factory.build(token, s);
-                s.push(newtoken);
+            thread_local std::vector<T> xs, ys;
+            xs.resize(rows * cols);
+            ys.resize(rows * cols);
+            for (std::size_t r = 0u; r < rows; ++r) {
+                const double y = y0 + static_cast<double>(row + r) * dy;
+                for (std::size_t c = 0u; c < cols; ++c) {
+                    xs[r * cols + c] = static_cast<T>(x0 + static_cast<double>(col + c) * dx);
+                    ys[r * cols + c] = static_cast<T>(y);
+                }
             }
 
-            if (s.size() > 1) { throw Exception::UnrecognizedSymbolException{}; }
+            function.eval_batch(xs, ys, out.subspan(row * nx + col, rows * cols));
+        });
+    }
+} // namespace
 
-            evaluator = s.top();
-            s.pop();
-        }
-        double ParsedFunction::eval(double x, double y) const { return evaluator->eval(x, y); }
+namespace InputHandling {
+    namespace _Internal {
 
-    } // namespace _Internal
+        ParsedFunction::ParsedFunction(std::span<const Lexeme> rpn, const allocator_type &allocator)
+            : ParsedFunction{rpn, Precision::Double, allocator} {}
 
-} // namespace InputHandling
+        ParsedFunction::ParsedFunction(std::span<const Lexeme> rpn,
+                                       Precision precision,
+                                       const allocator_type &allocator)
+            : ParsedFunction{rpn, precision, Accuracy::Exact, allocator} {}
 
-InputHandling::_Internal::ParsedFunction
-InputHandling::_Internal::ShuntingYardAlgorithm::parse_text_input(std::string input) {
-    std::stack<PToken> ops;
-    std::queue<PToken> tokens;
+        ParsedFunction::ParsedFunction(std::span<const Lexeme> rpn,
+                                       Precision precision,
+                                       Accuracy accuracy,
+                                       const allocator_type &allocator)
+            : ParsedFunction{lower_rpn(rpn, precision, allocator.resource()), accuracy} {}
 
-    remove_spaces(input);
-    format_minus_signs(input);
+        ParsedFunction::ParsedFunction(Program program, Accuracy accuracy) : compiled{std::move(program)} {
+            // Set first, so that constants fold the way the program would compute them.
+            compiled.accuracy = accuracy;
 
-    PToken previous_token;
-    while (input.size() > 0) {
-        auto token = extract_token(input);
+            // The optimizer's graphs only live for this call; typical expressions fit on the stack.
+            std::array<std::byte, 8192> buffer;
+            std::pmr::monotonic_buffer_resource scratch{buffer.data(), buffer.size()};
 
-        if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::Comma) {
-            --expected_number_of_commas;
-            continue;
+            stats = optimize(compiled, &scratch);
+#if defined(MATH_PARSER_PROFILING)
+            eval_profile = std::make_shared<Profiling::EvalProfile>(compiled.code.size());
+#endif
         }
-        if (is_type_of(token, Type::Function) && to_func(token)->num_args > 1) {
-            expected_number_of_commas += to_func(token)->num_args - 1;
+        double ParsedFunction::eval(double x, double y) const {
+#if defined(MATH_PARSER_PROFILING)
+            return execute_profiled(compiled.view(), x, y, *eval_profile);
+#else
+            return execute(compiled.view(), x, y);
+#endif
         }
-
-        if (is_type_of(token, Type::Operand)) {
-            tokens.push(token);
-        } else if (is_type_of(token, Type::Function)) {
-            ops.push(token);
-        } else if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::OpeningParenthesis) {
-            ops.push(token);
-        } else if (is_type_of(token, Type::Operator) && to_oprt(token)->op == Operator::ClosingParenthesis) {
-            while (ops.empty() == false) {
-                if (is_type_of(token, Type::Operator) && to_oprt(ops.top())->op == Operator::OpeningParenthesis) {
-                    break;
-                }
-
-                if (ops.size() == 1) { throw Exception::MismatchedParenthesis{}; }
-
-                tokens.push(ops.top());
-                ops.pop();
-            }
-
-            if (ops.empty() == true || is_type_of(ops.top(), Type::Operator) == false
-                || to_oprt(ops.top())->op != Operator::OpeningParenthesis) {
-                throw Exception::MismatchedParenthesis{};
-            }
-
-            ops.pop();
-
-            if (ops.empty() == false && is_type_of(ops.top(), Type::Function)) {
-                tokens.push(ops.top());
-                ops.pop();
-            }
-        } else if (*token == Type::Operator) {
-            while (ops.empty() == false && ops.top()->type == Type::Operator) {
-                const auto op1 = to_oprt(token);
-                const auto op2 = to_oprt(ops.top());
-
-                if (op2->op == Operator::OpeningParenthesis) { break; }
-                if (op1->precedence > op2->precedence) { break; }
-                if (op1->precedence == op2->precedence && op1->left_associative == false) { break; }
-
-                tokens.push(ops.top());
-                ops.pop();
-            }
-
-            ops.push(token);
+        double ParsedFunction::eval(std::span<const double> values) const { return execute(compiled.view(), values); }
+        void ParsedFunction::eval_batch(std::span<const double> xs,
+                                        std::span<const double> ys,
+                                        std::span<double> out) const {
+            execute_batch(compiled.view(), xs, ys, out);
         }
-
-        previous_token = token;
-    }
-
-    while (ops.empty() == false) {
-        if (is_type_of(ops.top(), Type::Operator) && to_oprt(ops.top())->op == Operator::OpeningParenthesis) {
-
-            throw Exception::MismatchedParenthesis{};
+        void ParsedFunction::eval_batch(std::span<const float> xs,
+                                        std::span<const float> ys,
+                                        std::span<float> out) const {
+            execute_batch(compiled.view(), xs, ys, out);
         }
-
-        tokens.push(ops.top());
-        ops.pop();
-    }
-
-    if (expected_number_of_commas != 0u) { throw Exception::IncorrectNumberOfArgumentsException{}; }
-
-    return ParsedFunction{tokens};
-}
-
-namespace InputHandling::_Internal {
-    PToken ShuntingYardAlgorithm::extract_token(std::string &input) {
-        assert(("Input string is empty." && input.empty() == false));
-
-        if (isdigit(input.at(0))) {
-            std::string number{input.at(0)};
-            input.erase(0, 1);
-            const auto pos = input.find_first_not_of("0123456789.");
-            if (pos != std::string::npos) {
-                number.append(input.begin(), input.begin() + pos);
-                input.erase(0, pos);
-            } else {
-                number.append(input.begin(), input.end());
-                input.erase(0, input.size());
-            }
-
-            return make_ptoken(OperandToken{Operand::Number, std::stof(number)});
+        void ParsedFunction::eval_columns(std::span<const std::span<const double>> columns,
+                                          std::span<double> out) const {
+            execute_columns(compiled.view(), columns, out);
         }
-
-        std::string matched_symbol;
-        auto token = find_token_in_map(input, &matched_symbol);
-
-        if (token) {
-            printf("[Debug: Matched symbol]: %s\n", matched_symbol.c_str());
-            input.erase(0, matched_symbol.size());
-            return token;
-        } else {
-            throw Exception::UnrecognizedSymbolException{};
+        void ParsedFunction::eval_columns(std::span<const std::span<const float>> columns,
+                                          std::span<float> out) const {
+            execute_columns(compiled.view(), columns, out);
         }
-
-        assert(("Execution should never reach here" && false));
-        return nullptr;
-    }
-    PToken ShuntingYardAlgorithm::find_token_in_map(std::string_view token, std::string *const str) {
-        for (const auto &[k, v] : token_map) {
-            if (token.starts_with(k)) {
-                if (str) { *str = k.c_str(); }
-
-                return v;
-            }
+        Gradient ParsedFunction::eval_with_gradient(double x, double y) const {
+            return execute_with_gradient(compiled.view(), x, y);
+        }
+        void ParsedFunction::eval_batch_with_gradient(std::span<const double> xs,
+                                                      std::span<const double> ys,
+                                                      std::span<Gradient> out) const {
+            execute_batch_with_gradient(compiled.view(), xs, ys, out);
+        }
+        Interval ParsedFunction::eval_interval(Interval x, Interval y) const {
+            return execute_interval(compiled.view(), x, y);
+        }
+        std::vector<Box> ParsedFunction::implicit_curve_cells(const Box &region, uint32_t max_depth) const {
+            return _Internal::implicit_curve_cells(compiled.view(), region, max_depth);
+        }
+        void ParsedFunction::eval_grid(double x0,
+                                       double x1,
+                                       std::size_t nx,
+                                       double y0,
+                                       double y1,
+                                       std::size_t ny,
+                                       std::span<double> out,
+                                       ThreadPool &pool) const {
+            sample_grid(*this, x0, x1, nx, y0, y1, ny, out, pool);
+        }
+        void ParsedFunction::eval_grid(double x0,
+                                       double x1,
+                                       std::size_t nx,
+                                       double y0,
+                                       double y1,
+                                       std::size_t ny,
+                                       std::span<float> out,
+                                       ThreadPool &pool) const {
+            sample_grid(*this, x0, x1, nx, y0, y1, ny, out, pool);
         }
 
-        return nullptr;
-    }
-    void ShuntingYardAlgorithm::remove_spaces(std::string &input) {
-        input.erase(std::remove_if(input.begin(), input.end(), std::isspace), input.end());
-    }
-    void ShuntingYardAlgorithm::format_minus_signs(std::string &input) {
-
-        enum class State { NotStarted, Number, Function };
-        State s = State::NotStarted;
-        std::string::size_type start;
-        int function_paren_balance{0};
-        for (std::string::size_type i = 0; i < input.size(); ++i) {
-            const auto c = input.at(i);
-
-            switch (s) {
-            case State::NotStarted:
-                if (c == '-' && (i == 0 || (i > 0 && isdigit(input.at(i - 1)) == false))) {
-                    start = i;
-                    if (isdigit(input.at(i + 1)) || input.at(i + 1) == 'x' || input.at(i + 1) == 'y') {
-                        s = State::Number;
-                    } else {
-                        s = State::Function;
-                    }
-                    continue;
-                }
-                break;
-            case State::Number: {
-                if (i == input.size() - 1) {
-                    ++i;
-                } else if (isdigit(c) || c == '.' || c == 'x' || c == 'y') {
-                    continue;
-                }
-
-                std::string new_substring{"(0"};
-                new_substring.append(input.begin() + start, input.begin() + i);
-                new_substring.append(")");
-                input.replace(input.begin() + start, input.begin() + i, "");
-                input.insert(start, new_substring);
-                i = start + new_substring.length();
-                s = State::NotStarted;
-                continue;
-            }
-
-            case State::Function: {
-                bool reached_last_paren = false;
-                if (c == '(') {
-                    ++function_paren_balance;
-                } else if (c == ')') {
-                    --function_paren_balance;
-                    if (function_paren_balance == 0) {
-                        reached_last_paren = true;
-                    } else if (function_paren_balance < 0) {
-                        throw Exception::MismatchedParenthesis{};
-                    }
-                }
+    } // namespace _Internal
 
-                if (reached_last_paren) {
-                    std::string new_substring{"((0-1)*"};
-                    new_substring.append(input.begin() + start + 1, input.begin() + i + 1);
-                    new_substring.append("))");
-                    input.replace(start, i, new_substring);
-                    i = start + new_substring.length();
-                    s = State::NotStarted;
-                    continue;
-                }
-            }
-            }
-        }
-    }
+} // namespace InputHandling
 
-    std::map<std::string, PToken, std::greater<>> ShuntingYardAlgorithm::token_map = {
-        {"(", make_ptoken(OperatorToken{Operator::OpeningParenthesis})},
-        {")", make_ptoken(OperatorToken{Operator::ClosingParenthesis})},
-        {"+", make_ptoken(OperatorToken{Operator::Add})},
-        {"-", make_ptoken(OperatorToken{Operator::Sub})},
-        {"*", make_ptoken(OperatorToken{Operator::Mul})},
-        {"/", make_ptoken(OperatorToken{Operator::Div})},
-        {"^", make_ptoken(OperatorToken{Operator::Pow})},
-        {",", make_ptoken(OperatorToken{Operator::Comma})},
+InputHandling::_Internal::ParsedFunction
+InputHandling::_Internal::ShuntingYardAlgorithm::parse_text_input(std::string_view source,
+                                                                  std::pmr::memory_resource *resource) {
+    return parse_text_input(source, Precision::Double, resource);
+}
 
-        {"x", make_ptoken(OperandToken{Operand::X})},
-        {"y", make_ptoken(OperandToken{Operand::Y})},
+InputHandling::_Internal::ParsedFunction
+InputHandling::_Internal::ShuntingYardAlgorithm::parse_text_input(std::string_view source,
+                                                                  Precision precision,
+                                                                  std::pmr::memory_resource *resource) {
+    return parse_text_input(source, {}, precision, Accuracy::Exact, resource);
+}
 
-        {"sin", make_ptoken(FunctionToken{Function::Sin, 1})},
-        {"cos", make_ptoken(FunctionToken{Function::Cos, 1})},
-        {"tan", make_ptoken(FunctionToken{Function::Tan, 1})},
-        {"sec", make_ptoken(FunctionToken{Function::Sec, 1})},
-        {"csc", make_ptoken(FunctionToken{Function::Csc, 1})},
-        {"cot", make_ptoken(FunctionToken{Function::Cot, 1})},
+InputHandling::_Internal::ParsedFunction
+InputHandling::_Internal::ShuntingYardAlgorithm::parse_text_input(std::string_view source,
+                                                                  Precision precision,
+                                                                  Accuracy accuracy,
+                                                                  std::pmr::memory_resource *resource) {
+    return parse_text_input(source, {}, precision, accuracy, resource);
+}
 
-        {"sinh", make_ptoken(FunctionToken{Function::Sinh, 1})},
-        {"cosh", make_ptoken(FunctionToken{Function::Cosh, 1})},
-        {"tanh", make_ptoken(FunctionToken{Function::Tanh, 1})},
-        {"sech", make_ptoken(FunctionToken{Function::Sech, 1})},
-        {"csch", make_ptoken(FunctionToken{Function::Csch, 1})},
-        {"coth", make_ptoken(FunctionToken{Function::Coth, 1})},
+InputHandling::_Internal::ParsedFunction
+InputHandling::_Internal::ShuntingYardAlgorithm::parse_text_input(std::string_view source,
+                                                                  std::span<const std::string_view> variables,
+                                                                  Precision precision,
+                                                                  Accuracy accuracy,
+                                                                  std::pmr::memory_resource *resource) {
+    return try_parse_text_input(source, variables, precision, accuracy, resource).value();
+}
 
-        {"asin", make_ptoken(FunctionToken{Function::Asin, 1})},
-        {"acos", make_ptoken(FunctionToken{Function::Acos, 1})},
-        {"atan", make_ptoken(FunctionToken{Function::Atan, 1})},
+InputHandling::_Internal::ParseResult<InputHandling::_Internal::ParsedFunction>
+InputHandling::_Internal::ShuntingYardAlgorithm::try_parse_text_input(std::string_view source,
+                                                                      Precision precision,
+                                                                      Accuracy accuracy,
+                                                                      std::pmr::memory_resource *resource) {
+    return try_parse_text_input(source, {}, precision, accuracy, resource);
+}
 
-        {"asinh", make_ptoken(FunctionToken{Function::Asinh, 1})},
-        {"acosh", make_ptoken(FunctionToken{Function::Acosh, 1})},
-        {"atanh", make_ptoken(FunctionToken{Function::Atanh, 1})},
+InputHandling::_Internal::ParseResult<InputHandling::_Internal::ParsedFunction>
+InputHandling::_Internal::ShuntingYardAlgorithm::try_parse_text_input(std::string_view source,
+                                                                      std::span<const std::string_view> variables,
+                                                                      Precision precision,
+                                                                      Accuracy accuracy,
+                                                                      std::pmr::memory_resource *resource) {
+    MATH_PARSER_PROFILE_PHASE(Parse);
 
-        {"ln", make_ptoken(FunctionToken{Function::Ln, 1})},
-        {"abs", make_ptoken(FunctionToken{Function::Abs, 1})},
-        {"exp", make_ptoken(FunctionToken{Function::Exp, 1})},
-        {"log", make_ptoken(FunctionToken{Function::Log, 1})},
-        {"sign", make_ptoken(FunctionToken{Function::Sign, 1})},
-        {"floor", make_ptoken(FunctionToken{Function::Floor, 1})},
-        {"ceil", make_ptoken(FunctionToken{Function::Ceil, 1})},
-        {"trunc", make_ptoken(FunctionToken{Function::Trunc, 1})},
-        {"fract", make_ptoken(FunctionToken{Function::Fract, 1})},
+    // The RPN is scratch as well: it is dropped once the program is built.
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource scratch{buffer.data(), buffer.size()};
 
-        {"max", make_ptoken(FunctionToken{Function::Max, 2})},
-        {"min", make_ptoken(FunctionToken{Function::Min, 2})},
-        {"step", make_ptoken(FunctionToken{Function::Step, 2})},
+    std::pmr::vector<Lexeme> rpn{&scratch};
+    if (const auto error = try_to_rpn(source, variables, rpn)) { return *error; }
 
-        {"clamp", make_ptoken(FunctionToken{Function::Clamp, 3})},
-        {"mix", make_ptoken(FunctionToken{Function::Mix, 3})},
-        {"smoothstep", make_ptoken(FunctionToken{Function::Smoothstep, 3})},
-    };
-} // namespace InputHandling::_Internal
+    auto program = try_lower_rpn(rpn, precision, resource);
+    if (program.has_value() == false) { return program.error(); }
+    return ParsedFunction{std::move(*program), accuracy};
+}
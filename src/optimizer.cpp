@@ -0,0 +1,258 @@
+#include "../include/math_parser/expression_graph.hpp"
+#include "../include/math_parser/profiler.hpp"
+#include "../include/math_parser/simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    bool is_constant(const ExpressionNode &node, double value) {
+        return node.op == OpCode::Constant && node.value == value;
+    }
+    // Tells the zeros apart, unlike is_constant.
+    bool is_zero(const ExpressionNode &node, bool negative) {
+        return is_constant(node, 0.) && std::signbit(node.value) == negative;
+    }
+
+    // `-e` is either a Neg node or written out as -1*e. A fast program also takes 0-e, which is +0 rather than -0
+    // for e = +0.
+    std::optional<uint32_t> negated_operand(const ExpressionGraph &graph, const ExpressionNode &node, bool fast) {
+        const auto &args = node.args;
+        if (node.op == OpCode::Neg) { return args[0]; }
+        if (fast && node.op == OpCode::Sub && is_constant(graph.nodes[args[0]], 0.)) { return args[1]; }
+        if (node.op == OpCode::Mul && is_constant(graph.nodes[args[0]], -1.)) { return args[1]; }
+        if (node.op == OpCode::Mul && is_constant(graph.nodes[args[1]], -1.)) { return args[0]; }
+        return std::nullopt;
+    }
+
+    // Evaluates an operation over constant arguments with the same code the program itself would run. In a
+    // single-precision program the result is rounded to float like every other constant, and in a fast one it is
+    // approximated like it would have been at run time.
+    double fold(const ExpressionGraph &graph, const ExpressionNode &node, Precision precision, Accuracy accuracy) {
+        std::array<Instruction, 4> code;
+        const auto num_args = arity(node.op);
+        for (uint32_t i = 0u; i < num_args; ++i) {
+            code[i] = {.op = OpCode::Constant, .value = graph.nodes[node.args[i]].value};
+        }
+        code[num_args] = {.op = node.op};
+
+        return execute({.code       = std::span{code}.first(num_args + 1u),
+                        .stack_size = num_args,
+                        .precision  = precision,
+                        .accuracy   = accuracy},
+                       0.,
+                       0.);
+    }
+
+    // 1/c in the precision of the program, or nothing when it is not a normal number there.
+    std::optional<double> reciprocal(double c, Precision precision) {
+        if (precision == Precision::Single) {
+            const float r = 1.f / static_cast<float>(c);
+            return std::isnormal(r) ? std::optional<double>{r} : std::nullopt;
+        }
+        const double r = 1. / c;
+        return std::isnormal(r) ? std::optional<double>{r} : std::nullopt;
+    }
+
+    // The reciprocal of c is exact when c is a power of two.
+    bool is_power_of_two(double c) {
+        int exponent;
+        return std::abs(std::frexp(c, &exponent)) == 0.5;
+    }
+
+    uint32_t constant(ExpressionGraph &graph, double value) { return graph.intern({OpCode::Constant, value}); }
+    uint32_t apply(ExpressionGraph &graph, OpCode op, uint32_t a) { return graph.intern({.op = op, .args = {a}}); }
+    uint32_t apply(ExpressionGraph &graph, OpCode op, uint32_t a, uint32_t b) {
+        return graph.intern({.op = op, .args = {a, b}});
+    }
+
+    // x^n for n >= 1 by repeated squaring.
+    uint32_t power(ExpressionGraph &graph, uint32_t base, uint32_t n) {
+        if (n == 1u) { return base; }
+
+        const auto square = apply(graph, OpCode::Square, power(graph, base, n / 2u));
+        return n % 2u == 0u ? square : apply(graph, OpCode::Mul, square, base);
+    }
+
+    // The function whose reciprocal `op` is: cos for sec, and so on.
+    std::optional<OpCode> reciprocal_function(OpCode op) {
+        switch (op) {
+        case OpCode::Sec: return OpCode::Cos;
+        case OpCode::Csc: return OpCode::Sin;
+        case OpCode::Cot: return OpCode::Tan;
+        case OpCode::Sech: return OpCode::Cosh;
+        case OpCode::Csch: return OpCode::Sinh;
+        case OpCode::Coth: return OpCode::Tanh;
+        default: return std::nullopt;
+        }
+    }
+
+    // Factors of a product, with a square counting as a * a.
+    std::optional<std::array<uint32_t, 2>> product(const ExpressionNode &node) {
+        if (node.op == OpCode::Mul) { return std::array{node.args[0], node.args[1]}; }
+        if (node.op == OpCode::Square) { return std::array{node.args[0], node.args[0]}; }
+        return std::nullopt;
+    }
+
+    // Replaces pow, division and the reciprocal functions by cheaper operations. In an exact program, x^0 = 1 and
+    // x / c = x * (1 / c) for c a power of two give the same bits; x^2 = x * x and x^-1 = 1 / x are correctly
+    // rounded, which libm's pow is not always, and may differ from it by 1 ulp. A fast program also takes these,
+    // each within the error given:
+    //
+    //     x^2, x^-1 (exact programs too)         x * x, 1 / x; correctly rounded, up to 1 ulp from pow
+    //     x^n for an integer 3 <= |n| <= 16      multiplications by squaring; |n| - 1 ulp, 1 more if n < 0
+    //     x^0.5, x^-0.5                          sqrt(x), 1 / sqrt(x); 0.5 ulp, 1.5 ulp
+    //     x / c                                  x * (1 / c); 1.5 ulp
+    //     a * sec(u), a / sec(u)                 a / cos(u), a * cos(u); 0.5 ulp, and likewise for csc, cot, sech,
+    //                                            csch and coth
+    //     a * b + c, a * b - c for constant c    one fused multiply-add, more accurate by up to 0.5 ulp
+    //
+    // Powers are exact in this sense only away from overflow and underflow of their intermediate products. The
+    // multiply-add is only formed when the library is built for FMA, as it is otherwise a slow library call.
+    std::optional<uint32_t> reduce_strength(ExpressionGraph &graph,
+                                            const ExpressionNode &node,
+                                            Precision precision,
+                                            Accuracy accuracy) {
+        const bool fast = accuracy == Accuracy::Fast;
+        const auto lhs  = graph.nodes[node.args[0]];
+        const auto rhs  = graph.nodes[node.args[1]];
+
+        switch (node.op) {
+        case OpCode::Pow: {
+            if (rhs.op != OpCode::Constant) { break; }
+
+            const double n = rhs.value;
+            if (n == 0.) { return constant(graph, 1.); }
+            if (n == 2.) { return apply(graph, OpCode::Square, node.args[0]); }
+            if (n == -1.) { return apply(graph, OpCode::Div, constant(graph, 1.), node.args[0]); }
+            if (fast == false) { break; }
+
+            uint32_t reduced;
+            if (std::abs(n) == 0.5) {
+                reduced = apply(graph, OpCode::Sqrt, node.args[0]);
+            } else if (std::trunc(n) == n && std::abs(n) <= 16.) {
+                reduced = power(graph, node.args[0], static_cast<uint32_t>(std::abs(n)));
+            } else {
+                break;
+            }
+            return n > 0. ? reduced : apply(graph, OpCode::Div, constant(graph, 1.), reduced);
+        }
+        case OpCode::Div:
+            if (rhs.op == OpCode::Constant && (fast || is_power_of_two(rhs.value))) {
+                if (const auto r = reciprocal(rhs.value, precision)) {
+                    return apply(graph, OpCode::Mul, node.args[0], constant(graph, *r));
+                }
+            }
+            if (const auto f = reciprocal_function(rhs.op); fast && f) {
+                return apply(graph, OpCode::Mul, node.args[0], apply(graph, *f, rhs.args[0]));
+            }
+            break;
+        case OpCode::Mul:
+            if (fast == false) { break; }
+            if (const auto f = reciprocal_function(rhs.op)) {
+                return apply(graph, OpCode::Div, node.args[0], apply(graph, *f, rhs.args[0]));
+            }
+            if (const auto f = reciprocal_function(lhs.op)) {
+                return apply(graph, OpCode::Div, node.args[1], apply(graph, *f, lhs.args[0]));
+            }
+            break;
+        case OpCode::Add:
+        case OpCode::Sub: {
+            if (fast == false || Simd::has_fma == false) { break; }
+
+            const bool add = node.op == OpCode::Add;
+            if (const auto ab = product(lhs); ab && (add || rhs.op == OpCode::Constant)) {
+                const auto c = add ? node.args[1] : constant(graph, -rhs.value);
+                return graph.intern({.op = OpCode::MulAdd, .args = {(*ab)[0], (*ab)[1], c}});
+            }
+            if (const auto ab = product(rhs); ab && add) {
+                return graph.intern({.op = OpCode::MulAdd, .args = {(*ab)[0], (*ab)[1], node.args[0]}});
+            }
+            break;
+        }
+        default: break;
+        }
+        return std::nullopt;
+    }
+
+    // Returns the index of a node equivalent to `node` in `graph`, adding new nodes only when needed.
+    uint32_t simplify(ExpressionGraph &graph, const ExpressionNode &node, Precision precision, Accuracy accuracy) {
+        const auto num_args = arity(node.op);
+        if (num_args == 0u) { return graph.intern(node); }
+
+        bool all_constant = true;
+        for (uint32_t i = 0u; i < num_args; ++i) { all_constant &= graph.nodes[node.args[i]].op == OpCode::Constant; }
+        if (all_constant) { return graph.intern({OpCode::Constant, fold(graph, node, precision, accuracy)}); }
+
+        // Adding -0 and subtracting +0 keep every value, the sign of zero included. The other zero turns -0 into +0,
+        // which only a fast program ignores.
+        const bool fast = accuracy == Accuracy::Fast;
+        const auto &lhs = graph.nodes[node.args[0]];
+        const auto &rhs = graph.nodes[node.args[1]];
+        switch (node.op) {
+        case OpCode::Add:
+            if (is_zero(rhs, true) || (fast && is_constant(rhs, 0.))) { return node.args[0]; }
+            if (is_zero(lhs, true) || (fast && is_constant(lhs, 0.))) { return node.args[1]; }
+            break;
+        case OpCode::Sub:
+            if (is_zero(rhs, false) || (fast && is_constant(rhs, 0.))) { return node.args[0]; }
+            break;
+        case OpCode::Mul:
+            if (is_constant(rhs, 1.)) { return node.args[0]; }
+            if (is_constant(lhs, 1.)) { return node.args[1]; }
+            break;
+        case OpCode::Div:
+        case OpCode::Pow:
+            if (is_constant(rhs, 1.)) { return node.args[0]; }
+            break;
+        default: break;
+        }
+
+        if (const auto reduced = reduce_strength(graph, node, precision, accuracy)) { return *reduced; }
+
+        if (const auto operand = negated_operand(graph, node, fast)) {
+            if (const auto inner = negated_operand(graph, graph.nodes[*operand], fast)) { return *inner; }
+        }
+
+        return graph.intern(node);
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    OptimizationStats optimize(Program &program, std::pmr::memory_resource *scratch) {
+        MATH_PARSER_PROFILE_PHASE(Optimize);
+
+        OptimizationStats stats;
+        stats.nodes_before = program.code.size();
+
+        const auto source = ExpressionGraph::from_program(program.code, scratch);
+        ExpressionGraph graph{scratch};
+        std::pmr::vector<uint32_t> remap(source.nodes.size(), scratch);
+
+        graph.nodes.reserve(source.nodes.size());
+        for (std::size_t i = 0u; i < source.nodes.size(); ++i) {
+            auto node = source.nodes[i];
+            for (uint32_t a = 0u; a < arity(node.op); ++a) { node.args[a] = remap[node.args[a]]; }
+
+            remap[i] = simplify(graph, node, program.precision, program.accuracy);
+        }
+        graph.root = remap[source.root];
+
+        // Built in the resource the program already uses, so the assignment takes over its buffer.
+        const auto precision     = program.precision;
+        const auto num_variables = program.num_variables;
+        const auto accuracy      = program.accuracy;
+        program                  = graph.to_program(program.code.get_allocator().resource());
+        program.precision        = precision;
+        program.num_variables    = num_variables;
+        program.accuracy         = accuracy;
+        stats.nodes_after        = std::count_if(program.code.begin(), program.code.end(), [](const Instruction &ins) {
+            return ins.op != OpCode::Store && ins.op != OpCode::Load;
+        });
+        return stats;
+    }
+} // namespace InputHandling::_Internal
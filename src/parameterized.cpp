@@ -0,0 +1,147 @@
+#include "../include/math_parser/parameterized.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+
+namespace InputHandling::_Internal {
+    ParameterizedFunction::ParameterizedFunction(std::string_view source,
+                                                 std::span<const std::string_view> parameters,
+                                                 Precision precision,
+                                                 Accuracy accuracy)
+        : names(parameters.begin(), parameters.end()), inputs(2u + parameters.size(), 0.),
+          dependents(parameters.size()) {
+        // x and y are inputs 0 and 1 and parameter k is input 2 + k, for the parser and the cached subexpressions.
+        std::vector<std::string_view> variables{"x", "y"};
+        for (const auto name : parameters) {
+            assert(("Parameters cannot be named x or y." && name != "x" && name != "y"));
+            variables.push_back(name);
+        }
+        const auto function = ShuntingYardAlgorithm::parse_text_input(source, variables, precision, accuracy);
+
+        std::array<std::byte, 16384> buffer;
+        std::pmr::monotonic_buffer_resource scratch{buffer.data(), buffer.size()};
+
+        const auto source_graph = ExpressionGraph::from_program(function.program().code, &scratch);
+        const auto &nodes       = source_graph.nodes;
+
+        // What every node reads, from its arguments, which precede it.
+        std::pmr::vector<char> reads_point(nodes.size(), false, &scratch);
+        std::pmr::vector<char> reads_parameter(nodes.size(), false, &scratch);
+        for (std::size_t i = 0u; i < nodes.size(); ++i) {
+            if (nodes[i].op == OpCode::Variable) {
+                reads_point[i]     = nodes[i].input < 2u;
+                reads_parameter[i] = nodes[i].input >= 2u;
+            }
+            for (uint32_t a = 0u; a < arity(nodes[i].op); ++a) {
+                reads_point[i]     = reads_point[i] || reads_point[nodes[i].args[a]];
+                reads_parameter[i] = reads_parameter[i] || reads_parameter[nodes[i].args[a]];
+            }
+        }
+
+        // A subexpression of the parameters alone is cached where the point-dependent part uses it, or where it
+        // is the whole function.
+        constexpr auto no_cache = UINT32_MAX;
+        std::pmr::vector<uint32_t> cache_of(nodes.size(), no_cache, &scratch);
+        const auto cache = [&](uint32_t node) {
+            if (reads_parameter[node] == false || reads_point[node] || cache_of[node] != no_cache) { return; }
+
+            cache_of[node] = static_cast<uint32_t>(caches.size());
+            auto &entry    = caches.emplace_back(Cache{.program = source_graph.to_subprogram(node), .targets = {}});
+            entry.program.precision     = precision;
+            entry.program.num_variables = static_cast<uint32_t>(inputs.size());
+            entry.program.accuracy      = accuracy;
+            for (const auto &ins : entry.program.code) {
+                if (ins.op != OpCode::Variable) { continue; }
+                auto &readers = dependents[ins.slot - 2u];
+                if (readers.empty() || readers.back() != cache_of[node]) { readers.push_back(cache_of[node]); }
+            }
+        };
+        cache(source_graph.root);
+        for (std::size_t i = 0u; i < nodes.size(); ++i) {
+            if (reads_point[i] == false) { continue; }
+            for (uint32_t a = 0u; a < arity(nodes[i].op); ++a) { cache(nodes[i].args[a]); }
+        }
+
+        // The program over the point: x and y become OpCode::X and OpCode::Y, and every cached subexpression a
+        // leaf that stands for it until it is lowered.
+        ExpressionGraph graph{&scratch};
+        std::pmr::vector<uint32_t> remap(nodes.size(), no_cache, &scratch);
+        for (std::size_t i = 0u; i < nodes.size(); ++i) {
+            if (cache_of[i] != no_cache) {
+                remap[i] = graph.add({.op = OpCode::Variable, .input = cache_of[i]});
+            } else if (reads_point[i] || nodes[i].op == OpCode::Constant) {
+                auto node = nodes[i];
+                if (node.op == OpCode::Variable) { node = {node.input == 0u ? OpCode::X : OpCode::Y}; }
+                for (uint32_t a = 0u; a < arity(node.op); ++a) { node.args[a] = remap[node.args[a]]; }
+                remap[i] = graph.intern(node);
+            }
+        }
+        graph.root = remap[source_graph.root];
+
+        // Leaves are pushed again at every use, so a cached value may have several constants to update.
+        compiled           = graph.to_program();
+        compiled.precision = precision;
+        compiled.accuracy  = accuracy;
+        for (std::size_t i = 0u; i < compiled.code.size(); ++i) {
+            auto &ins = compiled.code[i];
+            if (ins.op != OpCode::Variable) { continue; }
+
+            caches[ins.slot].targets.push_back(i);
+            ins = {.op = OpCode::Constant};
+        }
+
+        for (const auto &entry : caches) { refresh(entry); }
+    }
+
+    ParameterizedFunction::Parameter ParameterizedFunction::parameter(std::string_view name) const {
+        const auto it = std::find(names.begin(), names.end(), name);
+        assert(("No parameter of that name." && it != names.end()));
+        return {static_cast<uint32_t>(it - names.begin())};
+    }
+
+    void ParameterizedFunction::set(Parameter parameter, double value) {
+        assert(("Parameter out of range." && parameter.index < dependents.size()));
+        inputs[2u + parameter.index] = value;
+        for (const auto c : dependents[parameter.index]) { refresh(caches[c]); }
+    }
+
+    void ParameterizedFunction::set(std::span<const Parameter> parameters, std::span<const double> values) {
+        assert(("Every parameter needs a value." && parameters.size() == values.size()));
+
+        std::vector<char> stale(caches.size(), false);
+        for (std::size_t i = 0u; i < parameters.size(); ++i) {
+            assert(("Parameter out of range." && parameters[i].index < dependents.size()));
+            inputs[2u + parameters[i].index] = values[i];
+            for (const auto c : dependents[parameters[i].index]) { stale[c] = true; }
+        }
+        for (std::size_t c = 0u; c < caches.size(); ++c) {
+            if (stale[c]) { refresh(caches[c]); }
+        }
+    }
+
+    double ParameterizedFunction::eval(double x, double y) const { return execute(compiled.view(), x, y); }
+
+    void ParameterizedFunction::eval_batch(std::span<const double> xs,
+                                           std::span<const double> ys,
+                                           std::span<double> out) const {
+        execute_batch(compiled.view(), xs, ys, out);
+    }
+
+    void ParameterizedFunction::eval_batch(std::span<const float> xs,
+                                           std::span<const float> ys,
+                                           std::span<float> out) const {
+        execute_batch(compiled.view(), xs, ys, out);
+    }
+
+    Gradient ParameterizedFunction::eval_with_gradient(double x, double y) const {
+        return execute_with_gradient(compiled.view(), x, y);
+    }
+
+    void ParameterizedFunction::refresh(const Cache &cache) {
+        const double value = execute(cache.program.view(), std::span<const double>{inputs});
+        for (const auto target : cache.targets) { compiled.code[target].value = value; }
+    }
+} // namespace InputHandling::_Internal
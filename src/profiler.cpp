@@ -0,0 +1,155 @@
+#include "../include/math_parser/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+    using namespace InputHandling::_Internal;
+
+    struct PhaseCounters {
+        std::atomic<uint64_t> calls{0u};
+        std::atomic<uint64_t> nanoseconds{0u};
+    };
+
+    std::array<PhaseCounters, Profiling::num_phases> phase_counters;
+
+    constexpr std::string_view opcode_names[]{
+        "x",     "y",     "variable", "constant", "store", "load",  "output", "add",   "sub",   "mul",   "div",
+        "pow",   "neg",   "sin",      "cos",      "tan",   "sec",   "csc",    "cot",   "asin",  "acos",  "atan",
+        "sinh",  "cosh",  "tanh",     "sech",     "csch",  "coth",  "asinh",  "acosh", "atanh", "max",   "min",
+        "log",   "ln",    "abs",      "exp",      "sign",  "floor", "ceil",   "trunc", "fract", "clamp", "mix",
+        "step",  "smoothstep", "square", "sqrt", "mul_add",
+    };
+    static_assert(std::size(opcode_names) == static_cast<std::size_t>(OpCode::MulAdd) + 1u,
+                  "Every opcode needs a name.");
+} // namespace
+
+namespace InputHandling::_Internal::Profiling {
+    std::string_view name_of(Phase phase) {
+        switch (phase) {
+        case Phase::Parse: return "parse";
+        case Phase::Tokenize: return "tokenize";
+        case Phase::ShuntingYard: return "shunting_yard";
+        case Phase::Lower: return "lower";
+        case Phase::Optimize: return "optimize";
+        }
+        return "unknown";
+    }
+
+    std::string_view name_of(OpCode op) { return opcode_names[static_cast<std::size_t>(op)]; }
+
+    uint64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void record(Phase phase, uint64_t nanoseconds) {
+        auto &counters = phase_counters[static_cast<std::size_t>(phase)];
+        counters.calls.fetch_add(1u, std::memory_order_relaxed);
+        counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return now_ns();
+#endif
+    }
+
+    // Ticks the probe itself adds to every timed instruction: the cheapest of many empty measurements.
+    uint64_t probe_overhead() {
+        static const uint64_t overhead = [] {
+            uint64_t cheapest = ~uint64_t{0u};
+            for (int i = 0; i < 1000; ++i) {
+                const auto start = ticks();
+                cheapest         = std::min(cheapest, ticks() - start);
+            }
+            return cheapest;
+        }();
+        return overhead;
+    }
+
+    std::vector<PhaseReport> phase_report() {
+        std::vector<PhaseReport> phases;
+        for (std::size_t p = 0u; p < num_phases; ++p) {
+            phases.push_back({static_cast<Phase>(p),
+                              phase_counters[p].calls.load(std::memory_order_relaxed),
+                              phase_counters[p].nanoseconds.load(std::memory_order_relaxed)});
+        }
+        return phases;
+    }
+
+    void reset_phases() {
+        for (auto &counters : phase_counters) {
+            counters.calls.store(0u, std::memory_order_relaxed);
+            counters.nanoseconds.store(0u, std::memory_order_relaxed);
+        }
+    }
+
+    Report make_report(const Program &program, const EvalProfile *profile) {
+        Report report;
+        report.phases = phase_report();
+
+        std::array<OpCodeReport, std::size(opcode_names)> kinds;
+        for (std::size_t k = 0u; k < kinds.size(); ++k) { kinds[k].op = static_cast<OpCode>(k); }
+
+        for (std::size_t i = 0u; i < program.code.size(); ++i) {
+            NodeReport node{.index = static_cast<uint32_t>(i), .op = program.code[i].op};
+            if (profile) {
+                node.evaluations = profile->evaluations[i].load(std::memory_order_relaxed);
+                const auto overhead = node.evaluations * probe_overhead();
+                const auto ticks    = profile->ticks[i].load(std::memory_order_relaxed);
+                node.ticks          = ticks > overhead ? ticks - overhead : 0u;
+            }
+            report.nodes.push_back(node);
+
+            auto &kind = kinds[static_cast<std::size_t>(node.op)];
+            ++kind.nodes;
+            kind.evaluations += node.evaluations;
+            kind.ticks += node.ticks;
+        }
+
+        std::copy_if(kinds.begin(), kinds.end(), std::back_inserter(report.kinds), [](const OpCodeReport &kind) {
+            return kind.nodes > 0u;
+        });
+        std::stable_sort(report.kinds.begin(), report.kinds.end(), [](const auto &a, const auto &b) {
+            return a.ticks > b.ticks;
+        });
+        return report;
+    }
+
+    std::string Report::to_json() const {
+        std::string json = "{\n  \"phases\": [";
+        for (std::size_t i = 0u; i < phases.size(); ++i) {
+            json += i == 0u ? "\n" : ",\n";
+            json += "    {\"phase\": \"" + std::string{name_of(phases[i].phase)}
+                    + "\", \"calls\": " + std::to_string(phases[i].calls)
+                    + ", \"nanoseconds\": " + std::to_string(phases[i].nanoseconds) + "}";
+        }
+
+        json += "\n  ],\n  \"kinds\": [";
+        for (std::size_t i = 0u; i < kinds.size(); ++i) {
+            json += i == 0u ? "\n" : ",\n";
+            json += "    {\"op\": \"" + std::string{name_of(kinds[i].op)} + "\", \"nodes\": "
+                    + std::to_string(kinds[i].nodes) + ", \"evaluations\": " + std::to_string(kinds[i].evaluations)
+                    + ", \"ticks\": " + std::to_string(kinds[i].ticks) + "}";
+        }
+
+        json += "\n  ],\n  \"nodes\": [";
+        for (std::size_t i = 0u; i < nodes.size(); ++i) {
+            json += i == 0u ? "\n" : ",\n";
+            json += "    {\"index\": " + std::to_string(nodes[i].index) + ", \"op\": \""
+                    + std::string{name_of(nodes[i].op)} + "\", \"evaluations\": "
+                    + std::to_string(nodes[i].evaluations) + ", \"ticks\": " + std::to_string(nodes[i].ticks) + "}";
+        }
+        json += "\n  ]\n}\n";
+        return json;
+    }
+} // namespace InputHandling::_Internal::Profiling
@@ -0,0 +1,221 @@
+#include "../include/math_parser/program.hpp"
+#include "../include/math_parser/fast_math.hpp"
+#include "../include/math_parser/kernels.hpp"
+#include "../include/math_parser/profiler.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
+namespace {
+    using namespace InputHandling::_Internal;
+    namespace Fast = FastMath;
+
+    // Observes every executed instruction. This one does nothing and compiles away.
+    struct NoProbe {
+        uint64_t begin() const { return 0u; }
+        void end(std::size_t, uint64_t) const {}
+    };
+
+    struct ProfilingProbe {
+        uint64_t begin() const { return Profiling::ticks(); }
+        void end(std::size_t index, uint64_t start) const {
+            const auto elapsed = Profiling::ticks() - start;
+            profile.evaluations[index].fetch_add(1u, std::memory_order_relaxed);
+            profile.ticks[index].fetch_add(elapsed, std::memory_order_relaxed);
+        }
+
+        Profiling::EvalProfile &profile;
+    };
+
+    // Returns the value left on the stack. A fused program leaves none: it pops each result into `outputs`.
+    template <typename T, typename Probe>
+    T interpret(const ProgramView &program, const T *inputs, const Probe &probe, T *outputs = nullptr) {
+        constexpr uint32_t inline_storage_size = 64u;
+
+        // The stack and the slots share one buffer: slots first, stack after them.
+        T inline_storage[inline_storage_size];
+        std::vector<T> heap_storage;
+        T *slots = inline_storage;
+        if (program.num_slots + program.stack_size > inline_storage_size) {
+            heap_storage.resize(program.num_slots + program.stack_size);
+            slots = heap_storage.data();
+        }
+        T *sp = slots + program.num_slots;
+
+        const bool fast = program.accuracy == Accuracy::Fast;
+
+        for (std::size_t i = 0u; i < program.code.size(); ++i) {
+            const auto &ins  = program.code[i];
+            const auto start = probe.begin();
+
+            switch (ins.op) {
+            case OpCode::X: *sp++ = inputs[0]; break;
+            case OpCode::Y: *sp++ = inputs[1]; break;
+            case OpCode::Variable: *sp++ = inputs[ins.slot]; break;
+            case OpCode::Constant: *sp++ = static_cast<T>(ins.value); break;
+            case OpCode::Store: slots[ins.slot] = sp[-1]; break;
+            case OpCode::Load: *sp++ = slots[ins.slot]; break;
+            case OpCode::Output: outputs[ins.slot] = *--sp; break;
+
+            case OpCode::Add: --sp, sp[-1] = sp[-1] + sp[0]; break;
+            case OpCode::Sub: --sp, sp[-1] = sp[-1] - sp[0]; break;
+            case OpCode::Mul: --sp, sp[-1] = sp[-1] * sp[0]; break;
+            case OpCode::Div: --sp, sp[-1] = sp[-1] / sp[0]; break;
+            case OpCode::Pow: --sp, sp[-1] = std::pow(sp[-1], sp[0]); break;
+            case OpCode::Neg: sp[-1] = -sp[-1]; break;
+
+            case OpCode::Sin: sp[-1] = fast ? Fast::evaluate<Fast::Sin>(sp[-1]) : std::sin(sp[-1]); break;
+            case OpCode::Cos: sp[-1] = fast ? Fast::evaluate<Fast::Cos>(sp[-1]) : std::cos(sp[-1]); break;
+            case OpCode::Tan: sp[-1] = fast ? Fast::evaluate<Fast::Tan>(sp[-1]) : std::tan(sp[-1]); break;
+            case OpCode::Sec: sp[-1] = fast ? Fast::evaluate<Fast::Sec>(sp[-1]) : Kernels::sec(sp[-1]); break;
+            case OpCode::Csc: sp[-1] = fast ? Fast::evaluate<Fast::Csc>(sp[-1]) : Kernels::csc(sp[-1]); break;
+            case OpCode::Cot: sp[-1] = fast ? Fast::evaluate<Fast::Cot>(sp[-1]) : Kernels::cot(sp[-1]); break;
+
+            case OpCode::Sinh: sp[-1] = fast ? Fast::evaluate<Fast::Sinh>(sp[-1]) : std::sinh(sp[-1]); break;
+            case OpCode::Cosh: sp[-1] = fast ? Fast::evaluate<Fast::Cosh>(sp[-1]) : std::cosh(sp[-1]); break;
+            case OpCode::Tanh: sp[-1] = fast ? Fast::evaluate<Fast::Tanh>(sp[-1]) : std::tanh(sp[-1]); break;
+            case OpCode::Sech: sp[-1] = fast ? Fast::evaluate<Fast::Sech>(sp[-1]) : Kernels::sech(sp[-1]); break;
+            case OpCode::Csch: sp[-1] = fast ? Fast::evaluate<Fast::Csch>(sp[-1]) : Kernels::csch(sp[-1]); break;
+            case OpCode::Coth: sp[-1] = fast ? Fast::evaluate<Fast::Coth>(sp[-1]) : Kernels::coth(sp[-1]); break;
+
+            case OpCode::Asin: sp[-1] = std::asin(sp[-1]); break;
+            case OpCode::Acos: sp[-1] = std::acos(sp[-1]); break;
+            case OpCode::Atan: sp[-1] = std::atan(sp[-1]); break;
+
+            case OpCode::Asinh: sp[-1] = std::asinh(sp[-1]); break;
+            case OpCode::Acosh: sp[-1] = std::acosh(sp[-1]); break;
+            case OpCode::Atanh: sp[-1] = std::atanh(sp[-1]); break;
+
+            case OpCode::Ln: sp[-1] = fast ? Fast::evaluate<Fast::Ln>(sp[-1]) : std::log(sp[-1]); break;
+            case OpCode::Log: sp[-1] = fast ? Fast::evaluate<Fast::Log>(sp[-1]) : std::log10(sp[-1]); break;
+            case OpCode::Abs: sp[-1] = std::abs(sp[-1]); break;
+            case OpCode::Exp: sp[-1] = fast ? Fast::evaluate<Fast::Exp>(sp[-1]) : std::exp(sp[-1]); break;
+            case OpCode::Sign: sp[-1] = Kernels::sign(sp[-1]); break;
+            case OpCode::Floor: sp[-1] = std::floor(sp[-1]); break;
+            case OpCode::Ceil: sp[-1] = std::ceil(sp[-1]); break;
+            case OpCode::Trunc: sp[-1] = std::trunc(sp[-1]); break;
+            case OpCode::Fract: sp[-1] = Kernels::fract(sp[-1]); break;
+
+            case OpCode::Max: --sp, sp[-1] = Kernels::max(sp[-1], sp[0]); break;
+            case OpCode::Min: --sp, sp[-1] = Kernels::min(sp[-1], sp[0]); break;
+            case OpCode::Step: --sp, sp[-1] = Kernels::step(sp[-1], sp[0]); break;
+
+            case OpCode::Clamp: sp -= 2, sp[-1] = Kernels::clamp(sp[-1], sp[0], sp[1]); break;
+            case OpCode::Mix: sp -= 2, sp[-1] = Kernels::mix(sp[-1], sp[0], sp[1]); break;
+            case OpCode::Smoothstep: sp -= 2, sp[-1] = Kernels::smoothstep(sp[-1], sp[0], sp[1]); break;
+
+            case OpCode::Square: sp[-1] = Kernels::square(sp[-1]); break;
+            case OpCode::Sqrt: sp[-1] = Kernels::sqrt(sp[-1]); break;
+            case OpCode::MulAdd: sp -= 2, sp[-1] = Kernels::mul_add(sp[-1], sp[0], sp[1]); break;
+            }
+
+            probe.end(i, start);
+        }
+
+        return outputs ? T(0) : sp[-1];
+    }
+
+    // Inputs of type U in the scalar type T, converted only when the two differ.
+    template <typename T, typename U> class Inputs {
+      public:
+        Inputs(const U *values, std::size_t count) {
+            if constexpr (std::is_same_v<T, U>) {
+                data = values;
+            } else {
+                T *converted = inline_storage;
+                if (count > inline_storage_size) {
+                    heap_storage.resize(count);
+                    converted = heap_storage.data();
+                }
+                std::copy_n(values, count, converted);
+                data = converted;
+            }
+        }
+
+        const T *data;
+
+      private:
+        static constexpr std::size_t inline_storage_size = 16u;
+
+        T inline_storage[std::is_same_v<T, U> ? 1u : inline_storage_size];
+        std::vector<T> heap_storage;
+    };
+
+    // Runs the program in its own precision and returns the result as U.
+    template <typename U, typename Probe>
+    U evaluate(const ProgramView &program, const U *inputs, std::size_t num_inputs, const Probe &probe) {
+        assert(("Every input of the program needs a value." && num_inputs >= required_inputs(program)));
+
+        if (program.precision == Precision::Single) {
+            return static_cast<U>(interpret(program, Inputs<float, U>{inputs, num_inputs}.data, probe));
+        }
+        return static_cast<U>(interpret(program, Inputs<double, U>{inputs, num_inputs}.data, probe));
+    }
+
+    template <typename T, typename U> void evaluate_fused(const ProgramView &program, U x, U y, std::span<U> out) {
+        const U inputs[]{x, y};
+        if constexpr (std::is_same_v<T, U>) {
+            interpret(program, inputs, NoProbe{}, out.data());
+        } else {
+            constexpr uint32_t inline_outputs = 16u;
+
+            T inline_storage[inline_outputs];
+            std::vector<T> heap_storage;
+            T *outputs = inline_storage;
+            if (program.num_outputs > inline_outputs) {
+                heap_storage.resize(program.num_outputs);
+                outputs = heap_storage.data();
+            }
+
+            interpret(program, Inputs<T, U>{inputs, 2u}.data, NoProbe{}, outputs);
+            std::copy_n(outputs, program.num_outputs, out.data());
+        }
+    }
+} // namespace
+
+namespace InputHandling::_Internal {
+    double execute(const ProgramView &program, double x, double y) {
+        assert(("The program takes named variables." && program.num_variables <= 2u));
+        const double inputs[]{x, y};
+        return evaluate(program, inputs, 2u, NoProbe{});
+    }
+
+    float execute(const ProgramView &program, float x, float y) {
+        assert(("The program takes named variables." && program.num_variables <= 2u));
+        const float inputs[]{x, y};
+        return evaluate(program, inputs, 2u, NoProbe{});
+    }
+
+    double execute(const ProgramView &program, std::span<const double> values) {
+        return evaluate(program, values.data(), values.size(), NoProbe{});
+    }
+
+    float execute(const ProgramView &program, std::span<const float> values) {
+        return evaluate(program, values.data(), values.size(), NoProbe{});
+    }
+
+    void execute_fused(const ProgramView &program, double x, double y, std::span<double> out) {
+        assert(("Output span must hold every output of the program." && out.size() == program.num_outputs));
+        if (program.precision == Precision::Single) {
+            evaluate_fused<float>(program, x, y, out);
+        } else {
+            evaluate_fused<double>(program, x, y, out);
+        }
+    }
+
+    void execute_fused(const ProgramView &program, float x, float y, std::span<float> out) {
+        assert(("Output span must hold every output of the program." && out.size() == program.num_outputs));
+        if (program.precision == Precision::Single) {
+            evaluate_fused<float>(program, x, y, out);
+        } else {
+            evaluate_fused<double>(program, x, y, out);
+        }
+    }
+
+    double execute_profiled(const ProgramView &program, double x, double y, Profiling::EvalProfile &profile) {
+        const double inputs[]{x, y};
+        return evaluate(program, inputs, 2u, ProfilingProbe{profile});
+    }
+} // namespace InputHandling::_Internal
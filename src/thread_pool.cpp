@@ -0,0 +1,128 @@
+#include "../include/math_parser/thread_pool.hpp"
+
+#include <exception>
+
+namespace InputHandling::_Internal {
+    ThreadPool::ThreadPool(std::size_t num_threads) {
+        // One extra queue that only the threads calling parallel_for push into.
+        queues.resize(num_threads + 1u);
+        for (auto &queue : queues) { queue = std::make_unique<WorkQueue>(); }
+
+        workers.reserve(num_threads);
+        for (std::size_t i = 0u; i < num_threads; ++i) {
+            workers.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock{wake_mutex};
+            stopping = true;
+        }
+        wake.notify_all();
+
+        for (auto &worker : workers) { worker.join(); }
+    }
+
+    void ThreadPool::parallel_for(std::size_t count, const std::function<void(std::size_t)> &task) {
+        if (count == 0u) { return; }
+        if (count == 1u || workers.empty()) {
+            for (std::size_t i = 0u; i < count; ++i) { task(i); }
+            return;
+        }
+
+        // Announce the work before queueing it so `pending` never underflows when a worker is quick to pop.
+        {
+            std::lock_guard lock{wake_mutex};
+            pending.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Outlives every task queued below, since nothing returns before `remaining` reached zero. It is only
+        // decremented with the mutex held, so the waiter cannot destroy it while a worker is still notifying.
+        struct Batch {
+            explicit Batch(std::size_t count) : remaining{count} {}
+
+            std::mutex mutex;
+            std::condition_variable done;
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> failed{false};
+            std::exception_ptr error; // The first exception a task threw; the tasks after it are skipped.
+        } batch{count};
+
+        for (std::size_t i = 0u; i < count; ++i) {
+            auto &queue = *queues[i % queues.size()];
+
+            std::lock_guard lock{queue.mutex};
+            queue.tasks.emplace_back([&task, &batch, i] {
+                if (batch.failed.load(std::memory_order_relaxed) == false) {
+                    try {
+                        task(i);
+                    } catch (...) {
+                        std::lock_guard lock{batch.mutex};
+                        if (batch.error == nullptr) { batch.error = std::current_exception(); }
+                        batch.failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+
+                std::lock_guard lock{batch.mutex};
+                if (batch.remaining.fetch_sub(1u, std::memory_order_release) == 1u) { batch.done.notify_all(); }
+            });
+        }
+        wake.notify_all();
+
+        // Help until no task is left to take, then sleep until the ones other threads took have finished.
+        Task next;
+        while (batch.remaining.load(std::memory_order_acquire) != 0u && try_pop(queues.size() - 1u, next)) { next(); }
+        {
+            std::unique_lock lock{batch.mutex};
+            batch.done.wait(lock, [&batch] { return batch.remaining.load(std::memory_order_acquire) == 0u; });
+        }
+
+        if (batch.error) { std::rethrow_exception(batch.error); }
+    }
+
+    ThreadPool &ThreadPool::shared() {
+        static ThreadPool pool{std::max(1u, std::thread::hardware_concurrency()) - 1u};
+        return pool;
+    }
+
+    bool ThreadPool::try_pop(std::size_t queue_index, Task &task) {
+        {
+            auto &own = *queues[queue_index];
+            std::lock_guard lock{own.mutex};
+            if (own.tasks.empty() == false) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                pending.fetch_sub(1u, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        for (std::size_t offset = 1u; offset < queues.size(); ++offset) {
+            auto &victim = *queues[(queue_index + offset) % queues.size()];
+            std::lock_guard lock{victim.mutex};
+            if (victim.tasks.empty() == false) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                pending.fetch_sub(1u, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadPool::worker_loop(std::size_t queue_index) {
+        Task task;
+        while (true) {
+            if (try_pop(queue_index, task)) {
+                task();
+                continue;
+            }
+
+            std::unique_lock lock{wake_mutex};
+            wake.wait(lock, [this] { return stopping || pending.load(std::memory_order_relaxed) != 0u; });
+            if (stopping) { return; }
+        }
+    }
+} // namespace InputHandling::_Internal
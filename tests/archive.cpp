@@ -0,0 +1,108 @@
+// Archives: what is written evaluates the same once mapped, and corrupt files and fused programs are refused.
+
+#include "../include/math_parser/archive.hpp"
+#include "../include/math_parser/expression_graph.hpp"
+#include "check.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace InputHandling;
+using InputHandling::_Internal::ExpressionGraph;
+
+namespace {
+    std::filesystem::path scratch_file(const char *name) {
+        return std::filesystem::temp_directory_path() / (std::string{"math_parser_test_"} + name + ".mpa");
+    }
+
+    void write_bytes(const std::filesystem::path &path, const std::string &bytes) {
+        std::ofstream{path, std::ios::binary | std::ios::trunc}.write(bytes.data(),
+                                                                      static_cast<std::streamsize>(bytes.size()));
+    }
+} // namespace
+
+int main() {
+    constexpr const char *sources[] = {"x + 0", "sin(x) * cos(y) + 2 ^ x", "smoothstep(0, 1, x * y)", "x ^ 2 / 4"};
+    const double values[]           = {0., -0., 0.5, -1.25, 3.};
+
+    ArchiveWriter writer;
+    for (const char *source : sources) { writer.add(source, ShuntingYardAlgorithm::parse_text_input(source)); }
+    writer.add("fast", ShuntingYardAlgorithm::parse_text_input("exp(x) * y", Precision::Double, Accuracy::Fast));
+    writer.add("single", ShuntingYardAlgorithm::parse_text_input("x / 3 + y", Precision::Single));
+
+    const auto path = scratch_file("archive");
+    writer.write(path);
+    std::ostringstream bytes;
+    writer.write(bytes);
+
+    {
+        const MappedArchive archive{path};
+        CHECK(archive.size() == std::size(sources) + 2u);
+        for (std::size_t i = 0u; i < std::size(sources); ++i) {
+            CHECK(archive.source(i) == sources[i]);
+            const auto function = ShuntingYardAlgorithm::parse_text_input(sources[i]);
+            for (const double x : values) {
+                for (const double y : values) { CHECK(Check::same_bits(archive.eval(i, x, y), function.eval(x, y))); }
+            }
+        }
+        CHECK(archive.program(4u).accuracy == Accuracy::Fast);
+        CHECK(archive.program(5u).precision == Precision::Single);
+
+        double out[std::size(values)];
+        archive.eval_batch(1u, values, values, out);
+        for (std::size_t i = 0u; i < std::size(values); ++i) {
+            CHECK(Check::same_bits(out[i], archive.eval(1u, values[i], values[i])));
+        }
+    }
+
+    // Truncated anywhere, or with a wrong magic, version or index, the file is refused.
+    const std::string valid = bytes.str();
+    const auto broken       = scratch_file("broken");
+    for (const std::size_t size : {std::size_t{0u}, std::size_t{10u}, std::size_t{30u}, valid.size() - 16u}) {
+        write_bytes(broken, valid.substr(0u, size));
+        CHECK_THROWS(MappedArchive{broken}, Exception::InvalidArchiveException);
+    }
+    for (const std::size_t offset : {std::size_t{0u}, std::size_t{8u}, std::size_t{24u}}) {
+        std::string corrupt = valid;
+        corrupt[offset] ^= 0x40;
+        write_bytes(broken, corrupt);
+        CHECK_THROWS(MappedArchive{broken}, Exception::InvalidArchiveException);
+    }
+    CHECK_THROWS(MappedArchive{scratch_file("missing")}, std::system_error);
+
+    // A fused program has several outputs and no place in an archive.
+    const auto a = ShuntingYardAlgorithm::parse_text_input("x + y");
+    const auto b = ShuntingYardAlgorithm::parse_text_input("x * y");
+    ExpressionGraph graph;
+    const uint32_t roots[] = {graph.merge(a.program().code), graph.merge(b.program().code)};
+    CHECK_THROWS(writer.add("fused", graph.to_fused_program(roots)), Exception::InvalidArchiveException);
+
+    // Nor does a program over more than two named variables, which eval() could not feed.
+    constexpr std::string_view two[] = {"a", "b"}, three[] = {"a", "b", "c"};
+    CHECK_THROWS(writer.add("three", ShuntingYardAlgorithm::parse_text_input("a + b * c", three)),
+                 Exception::InvalidArchiveException);
+
+    ArchiveWriter named;
+    const auto function = ShuntingYardAlgorithm::parse_text_input("a - b / 2", two);
+    named.add("two", function);
+    std::ostringstream named_bytes;
+    named.write(named_bytes);
+    std::string patched = named_bytes.str();
+    write_bytes(broken, patched);
+    {
+        const MappedArchive archive{broken};
+        const double inputs[] = {3., 5.};
+        CHECK(Check::same_bits(archive.eval(0u, 3., 5.), function.eval(inputs)));
+    }
+    // A reader refuses such an entry as well.
+    patched[sizeof(_Internal::ArchiveHeader) + offsetof(_Internal::ArchiveEntry, num_variables)] = 3;
+    write_bytes(broken, patched);
+    CHECK_THROWS(MappedArchive{broken}, Exception::InvalidArchiveException);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(broken);
+    return Check::result();
+}
@@ -0,0 +1,154 @@
+// Batched evaluation against the per-point one, bit for bit: for double and float spans, in both precisions, over
+// columns of named variables, and over grids, including rows longer than a tile.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <span>
+#include <string_view>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    constexpr const char *expressions[] = {
+        "x * y - x / 3 + 1",
+        "sin(x) * cos(y) + tan(x * y) + sec(y)",
+        "exp(-(x * x + y * y) / 2) + ln(x) + log(y)",
+        "sinh(x) + cosh(y) + tanh(x) + sech(y) + csch(x) + coth(y)",
+        "x ^ y + x ^ 2 + y ^ -3 + x ^ 0.5",
+        "max(x, y) - min(x, 2) + abs(y) + sign(x) + floor(y) + fract(x)",
+        "smoothstep(-1, 1, x) + mix(x, y, 0.25) + clamp(x * y, -1, 1) + step(x, y)",
+        "asin(x / 4) + acos(y / 4) + atan(x * y) + asinh(x) + acosh(y) + atanh(x / 8)",
+    };
+
+    constexpr Precision precisions[] = {Precision::Double, Precision::Single};
+    constexpr Accuracy accuracies[]  = {Accuracy::Exact, Accuracy::Fast};
+
+    // Several blocks and a partial one, with the special values first; shifted by one for odd seeds, so that x
+    // and y do not always meet the same one.
+    template <typename T> std::vector<T> points(std::size_t n, uint64_t seed) {
+        std::mt19937_64 generator{seed};
+        std::uniform_real_distribution<T> uniform{T(-4), T(4)};
+        std::vector<T> values(n);
+        for (auto &v : values) { v = uniform(generator); }
+
+        const T special[] = {T(0), -T(0), std::numeric_limits<T>::infinity(), -std::numeric_limits<T>::infinity(),
+                             std::numeric_limits<T>::quiet_NaN(), std::numeric_limits<T>::denorm_min()};
+        std::copy(std::begin(special), std::end(special), values.begin() + static_cast<std::ptrdiff_t>(seed % 2u));
+        return values;
+    }
+
+    // eval_batch over spans of T against eval of the same points.
+    template <typename T> void check_batch(const char *text, const ParsedFunction &function) {
+        const auto xs = points<T>(1000u, 1u);
+        const auto ys = points<T>(1000u, 2u);
+        std::vector<T> out(xs.size());
+        function.eval_batch(xs, ys, out);
+
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            const T expected = static_cast<T>(function.eval(xs[i], ys[i]));
+            if (CHECK(Check::same_bits(out[i], expected)) == false) {
+                std::fprintf(stderr, "  %s at x = %g, y = %g\n", text, double(xs[i]), double(ys[i]));
+            }
+        }
+    }
+
+    // eval_columns over columns of T against eval of every row.
+    template <typename T> void check_columns(const char *text, const ParsedFunction &function, std::size_t n) {
+        std::vector<std::vector<T>> data;
+        for (std::size_t k = 0u; k < n; ++k) { data.push_back(points<T>(777u, 10u + k)); }
+        const std::vector<std::span<const T>> columns(data.begin(), data.end());
+        std::vector<T> out(data.front().size());
+        function.eval_columns(columns, out);
+
+        std::vector<double> row(n);
+        for (std::size_t i = 0u; i < out.size(); ++i) {
+            for (std::size_t k = 0u; k < n; ++k) { row[k] = data[k][i]; }
+            const T expected = static_cast<T>(function.eval(row));
+            if (CHECK(Check::same_bits(out[i], expected)) == false) { std::fprintf(stderr, "  %s row %zu\n", text, i); }
+        }
+    }
+
+    // eval_grid against eval of every grid point, with the coordinates rounded to T as the batches see them.
+    template <typename T>
+    void check_grid(const char *text, const ParsedFunction &function, std::size_t nx, std::size_t ny,
+                    ThreadPool &pool) {
+        constexpr double x0 = -3.5, x1 = 2.25, y0 = -1.75, y1 = 3.;
+        std::vector<T> out(nx * ny);
+        function.eval_grid(x0, x1, nx, y0, y1, ny, out, pool);
+
+        const double dx = nx > 1u ? (x1 - x0) / static_cast<double>(nx - 1u) : 0.;
+        const double dy = ny > 1u ? (y1 - y0) / static_cast<double>(ny - 1u) : 0.;
+        for (std::size_t j = 0u; j < ny; ++j) {
+            const T y = static_cast<T>(y0 + static_cast<double>(j) * dy);
+            for (std::size_t i = 0u; i < nx; ++i) {
+                const T x        = static_cast<T>(x0 + static_cast<double>(i) * dx);
+                const T expected = static_cast<T>(function.eval(double(x), double(y)));
+                if (CHECK(Check::same_bits(out[j * nx + i], expected)) == false) {
+                    std::fprintf(stderr, "  %s at (%zu, %zu) of %zu x %zu\n", text, i, j, nx, ny);
+                    return;
+                }
+            }
+        }
+    }
+} // namespace
+
+int main() {
+    for (const auto precision : precisions) {
+        for (const auto accuracy : accuracies) {
+            for (const char *text : expressions) {
+                const auto function = ShuntingYardAlgorithm::parse_text_input(text, precision, accuracy);
+                check_batch<double>(text, function);
+                check_batch<float>(text, function);
+            }
+        }
+    }
+
+    // Named variables, in declaration order; a column per variable, and x and y as the first two otherwise.
+    constexpr std::string_view names[] = {"mass", "v", "h", "g"};
+    constexpr const char *named[]      = {"mass * v * v / 2 + mass * g * h", "sin(v) * exp(-h / g) + max(mass, v)"};
+    for (const auto precision : precisions) {
+        for (const auto accuracy : accuracies) {
+            for (const char *text : named) {
+                const auto function = ShuntingYardAlgorithm::parse_text_input(text, names, precision, accuracy);
+                check_columns<double>(text, function, 4u);
+                check_columns<float>(text, function, 4u);
+            }
+            const auto function = ShuntingYardAlgorithm::parse_text_input(expressions[1], precision, accuracy);
+            check_columns<double>(expressions[1], function, 2u);
+        }
+    }
+
+    // Grids of one point, one row, one column, and rows longer than a tile of 8192 points, spread over a pool.
+    ThreadPool pool{3u};
+    constexpr std::size_t sizes[][2] = {{1u, 1u}, {57u, 1u}, {1u, 33u}, {301u, 203u}, {20000u, 3u}};
+    for (const auto precision : precisions) {
+        for (const auto accuracy : accuracies) {
+            for (const char *text : {expressions[0], expressions[2], expressions[5]}) {
+                const auto function = ShuntingYardAlgorithm::parse_text_input(text, precision, accuracy);
+                for (const auto &size : sizes) {
+                    check_grid<double>(text, function, size[0], size[1], pool);
+                    check_grid<float>(text, function, size[0], size[1], pool);
+                }
+            }
+        }
+    }
+
+    // Single precision computes in float whatever the type of the arguments: 2^24 + 1 rounds back to 2^24.
+    const auto single = ShuntingYardAlgorithm::parse_text_input("x + 1 - x", Precision::Single);
+    const auto dual   = ShuntingYardAlgorithm::parse_text_input("x + 1 - x", Precision::Double);
+    CHECK(single.eval(16777216., 0.) == 0. && dual.eval(16777216., 0.) == 1.);
+    const double xs[] = {16777216.};
+    double out[1];
+    single.eval_batch(xs, xs, out);
+    CHECK(out[0] == 0.);
+    const auto third = ShuntingYardAlgorithm::parse_text_input("x / 3", Precision::Single);
+    CHECK(third.eval(1., 0.) == static_cast<double>(1.f / 3.f));
+
+    return Check::result();
+}
@@ -0,0 +1,41 @@
+#pragma once
+// The few checks the tests need. A failed CHECK reports where it failed and the test goes on; main returns
+// Check::result(), so ctest sees every failure of a run at once.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Check {
+    inline int failures = 0;
+
+    inline bool report(bool passed, const char *condition, const char *file, int line) {
+        if (passed == false) {
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+            ++failures;
+        }
+        return passed;
+    }
+
+    inline int result() {
+        if (failures != 0) { std::fprintf(stderr, "%d check(s) failed\n", failures); }
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Bit for bit, except that any two NaNs are equal: their sign and payload are not specified.
+    template <typename T> bool same_bits(T a, T b) {
+        return std::memcmp(&a, &b, sizeof(T)) == 0 || (std::isnan(a) && std::isnan(b));
+    }
+} // namespace Check
+
+#define CHECK(condition) ::Check::report(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+// Throws `exception` when evaluating `expression`.
+#define CHECK_THROWS(expression, exception)                                                                    \
+    do {                                                                                                       \
+        bool thrown = false;                                                                                   \
+        try {                                                                                                  \
+            static_cast<void>(expression);                                                                     \
+        } catch (const exception &) { thrown = true; }                                                         \
+        ::Check::report(thrown, #expression " throws " #exception, __FILE__, __LINE__);                       \
+    } while (false)
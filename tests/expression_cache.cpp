@@ -0,0 +1,31 @@
+// ExpressionCache: keys, hits and misses, and that a cached formula means what parsing it would.
+
+#include "../include/math_parser/expression_cache.hpp"
+#include "check.hpp"
+
+using namespace InputHandling;
+using InputHandling::_Internal::ExpressionCache;
+
+int main() {
+    CHECK(ExpressionCache::normalize(" 1 +\t2 ") == "1+2");
+    CHECK(ExpressionCache::normalize("sin ( x )") == "sin(x)");
+    CHECK(ExpressionCache::normalize("1 2") == "1 2");
+    CHECK(ExpressionCache::normalize("x  -  - y") == "x--y");
+
+    ExpressionCache cache;
+    const auto sum = cache.get("x + y");
+    CHECK(sum->eval(1., 2.) == 3.);
+    CHECK(cache.get("x+y") == sum);
+    CHECK(cache.statistics().hits == 1u);
+    CHECK(cache.statistics().misses == 1u);
+
+    // Spacing that separates tokens is part of the formula, whichever of the two is cached first.
+    CHECK(cache.get("12")->eval(0., 0.) == 12.);
+    CHECK_THROWS(cache.get("1 2"), UnrecognizedSymbolException);
+    CHECK(cache.statistics().entries == 2u);
+
+    cache.clear();
+    CHECK(cache.statistics().entries == 0u);
+
+    return Check::result();
+}
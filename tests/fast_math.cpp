@@ -0,0 +1,159 @@
+// The approximations of fast_math.hpp against long double libm, within the error documented for each, and the
+// batched evaluation of Fast programs against the per-point one.
+
+#include "../include/math_parser/fast_math.hpp"
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace InputHandling;
+namespace FastMath = InputHandling::_Internal::FastMath;
+
+namespace {
+    // Error of `value` in units of the last place of the correctly rounded result.
+    double ulps(double value, long double exact) {
+        const double rounded = static_cast<double>(exact);
+        if (std::isnan(value) || std::isnan(rounded)) { return std::isnan(value) == std::isnan(rounded) ? 0. : 1e300; }
+        if (std::isinf(value) || std::isinf(rounded) || rounded == 0.) { return value == rounded ? 0. : 1e300; }
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        const double ulp      = std::nextafter(std::abs(rounded), infinity) - std::abs(rounded);
+        return static_cast<double>(std::abs(static_cast<long double>(value) - exact)) / ulp;
+    }
+
+    // The same in float, for single-precision programs.
+    double float_ulps(float value, long double exact) {
+        const float rounded = static_cast<float>(exact);
+        if (std::isinf(value) || std::isinf(rounded) || rounded == 0.f) { return value == rounded ? 0. : 1e300; }
+
+        const float infinity = std::numeric_limits<float>::infinity();
+        const float ulp      = std::nextafter(std::abs(rounded), infinity) - std::abs(rounded);
+        return static_cast<double>(std::abs(static_cast<long double>(value) - exact)) / ulp;
+    }
+
+    struct Kernel {
+        const char *name;
+        double (*fast)(double);
+        float (*fast_float)(float);
+        long double (*exact)(long double);
+        double low, high; // Sampled uniformly; over the whole domain on a logarithmic scale if both are 0.
+        double bound;     // In ulp, as documented in fast_math.hpp.
+    };
+
+    template <typename F>
+    constexpr Kernel
+    kernel(const char *name, long double (*exact)(long double), double low, double high, double bound) {
+        return {name, &FastMath::evaluate<F, double>, &FastMath::evaluate<F, float>, exact, low, high, bound};
+    }
+
+    long double secl(long double x) { return 1 / cosl(x); }
+    long double cscl(long double x) { return 1 / sinl(x); }
+    long double cotl(long double x) { return 1 / tanl(x); }
+    long double sechl(long double x) { return 1 / coshl(x); }
+    long double cschl(long double x) { return 1 / sinhl(x); }
+    long double cothl(long double x) { return 1 / tanhl(x); }
+
+    constexpr double trig = FastMath::trig_limit;
+    const Kernel kernels[] = {
+        kernel<FastMath::Exp>("exp", expl, -708., 709., 1.),
+        kernel<FastMath::Ln>("ln", logl, 0., 0., 1.5),
+        kernel<FastMath::Ln>("ln", logl, 0.5, 2., 1.5),
+        kernel<FastMath::Log>("log", log10l, 0., 0., 2.),
+        kernel<FastMath::Log>("log", log10l, 0.5, 2., 2.),
+        kernel<FastMath::Sin>("sin", sinl, -trig, trig, 2.5),
+        kernel<FastMath::Sin>("sin", sinl, -4., 4., 2.5),
+        kernel<FastMath::Cos>("cos", cosl, -trig, trig, 2.5),
+        kernel<FastMath::Cos>("cos", cosl, -4., 4., 2.5),
+        kernel<FastMath::Tan>("tan", tanl, -trig, trig, 4.),
+        kernel<FastMath::Tan>("tan", tanl, -4., 4., 4.),
+        kernel<FastMath::Cot>("cot", cotl, -trig, trig, 4.),
+        kernel<FastMath::Sec>("sec", secl, -trig, trig, 3.5),
+        kernel<FastMath::Csc>("csc", cscl, -trig, trig, 3.5),
+        kernel<FastMath::Sinh>("sinh", sinhl, -708., 708., 2.),
+        kernel<FastMath::Sinh>("sinh", sinhl, -3., 3., 2.),
+        kernel<FastMath::Cosh>("cosh", coshl, -708., 708., 2.),
+        kernel<FastMath::Cosh>("cosh", coshl, -3., 3., 2.),
+        kernel<FastMath::Tanh>("tanh", tanhl, -30., 30., 3.),
+        kernel<FastMath::Tanh>("tanh", tanhl, -2., 2., 3.),
+        kernel<FastMath::Sech>("sech", sechl, -708., 708., 2.5),
+        kernel<FastMath::Csch>("csch", cschl, -708., 708., 3.),
+        kernel<FastMath::Csch>("csch", cschl, -3., 3., 3.),
+        kernel<FastMath::Coth>("coth", cothl, -3., 3., 3.5),
+    };
+
+    constexpr std::size_t samples = 200000u;
+
+    // Arguments for one sweep: uniform over the range, every fourth one near 0 (or 1 for positive ranges), where
+    // the reduced arguments and the cancellations are.
+    std::vector<double> arguments(const Kernel &kernel, uint64_t seed) {
+        std::mt19937_64 generator{seed};
+        std::uniform_real_distribution<double> uniform{kernel.low, kernel.high};
+        std::uniform_real_distribution<double> exponent{-1022., 1024.};
+        std::uniform_real_distribution<double> near{-2., 2.};
+
+        std::vector<double> values(samples);
+        for (std::size_t i = 0u; i < samples; ++i) {
+            if (kernel.low == 0. && kernel.high == 0.) {
+                values[i] = std::exp2(exponent(generator));
+            } else if (i % 4u == 1u) {
+                values[i] = kernel.low < 0. ? near(generator) : 1. + near(generator) / 4.;
+            } else {
+                values[i] = uniform(generator);
+            }
+        }
+        return values;
+    }
+} // namespace
+
+int main() {
+    uint64_t seed = 1u;
+    for (const auto &kernel : kernels) {
+        double worst = 0., worst_float = 0., at = 0.;
+        for (const double x : arguments(kernel, seed++)) {
+            const long double exact = kernel.exact(x);
+            const double error      = ulps(kernel.fast(x), exact);
+            if (error > worst) { worst = error, at = x; }
+
+            const float xf = static_cast<float>(x);
+            worst_float    = std::max(worst_float, float_ulps(kernel.fast_float(xf), kernel.exact(xf)));
+        }
+
+        if (CHECK(worst <= kernel.bound) == false) {
+            std::fprintf(stderr, "  %s: %.3f ulp at %.17g, documented %.1f\n", kernel.name, worst, at, kernel.bound);
+        }
+        if (CHECK(worst_float <= 1.) == false) {
+            std::fprintf(stderr, "  %s in float: %.3f ulp\n", kernel.name, worst_float);
+        }
+    }
+
+    // Batches run the same approximations a pack at a time and must round identically.
+    std::vector<double> xs(1027u), ys(1027u), batch(1027u);
+    std::mt19937_64 generator{seed};
+    std::uniform_real_distribution<double> distribution{-8., 8.};
+    for (std::size_t i = 0u; i < xs.size(); ++i) { xs[i] = distribution(generator), ys[i] = distribution(generator); }
+    xs[0] = 0., xs[1] = -0., xs[2] = 700., xs[3] = 1e6, xs[4] = std::numeric_limits<double>::infinity();
+    xs[5] = std::nan("");
+
+    constexpr const char *expressions[] = {
+        "exp(x) + ln(y) + log(x)",
+        "sin(x) + cos(y) + tan(x) + cot(y) + sec(x) + csc(y)",
+        "sinh(x) + cosh(y) + tanh(x) + sech(y) + csch(x) + coth(y)",
+    };
+    for (const char *expression : expressions) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(expression, Precision::Double, Accuracy::Fast);
+        function.eval_batch(xs, ys, batch);
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            if (CHECK(Check::same_bits(batch[i], function.eval(xs[i], ys[i]))) == false) {
+                std::fprintf(stderr, "  %s at x = %g, y = %g\n", expression, xs[i], ys[i]);
+            }
+        }
+    }
+
+    return Check::result();
+}
@@ -0,0 +1,78 @@
+// FusedFunction: every output is, bit for bit, what its function computes on its own, and shared subexpressions are
+// compiled once.
+
+#include "../include/math_parser/fused.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    constexpr const char *related[] = {
+        "sin(x) * y",
+        "sin(x) * y + 1",
+        "cos(x) + sin(x) * y",
+        "exp(-(x * x + y * y) / 2)",
+        "exp(-(x * x + y * y) / 2) * sin(x)",
+        "x ^ 2 + y ^ 3 - smoothstep(0, 1, x * y)",
+    };
+
+    std::vector<ParsedFunction> parse_all(Precision precision, Accuracy accuracy) {
+        std::vector<ParsedFunction> functions;
+        for (const char *text : related) {
+            functions.push_back(ShuntingYardAlgorithm::parse_text_input(text, precision, accuracy));
+        }
+        return functions;
+    }
+
+    template <typename T> void check_against_functions(Precision precision, Accuracy accuracy) {
+        const auto functions = parse_all(precision, accuracy);
+        const FusedFunction fused{functions};
+        CHECK(fused.size() == functions.size());
+
+        // More than one block of points, and the special values.
+        std::mt19937_64 generator{5u};
+        std::uniform_real_distribution<T> uniform{T(-3), T(3)};
+        std::vector<T> xs(1000u), ys(1000u);
+        for (std::size_t i = 0u; i < xs.size(); ++i) { xs[i] = uniform(generator), ys[i] = uniform(generator); }
+        xs[0] = T(0), ys[0] = -T(0), xs[1] = std::numeric_limits<T>::infinity(), ys[2] = std::nan("");
+
+        std::vector<std::vector<T>> results(functions.size(), std::vector<T>(xs.size()));
+        std::vector<std::span<T>> outs(results.begin(), results.end());
+        fused.eval_batch(xs, ys, outs);
+
+        std::vector<T> point(functions.size());
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            fused.eval(xs[i], ys[i], point);
+            for (std::size_t k = 0u; k < functions.size(); ++k) {
+                const T expected = static_cast<T>(functions[k].eval(xs[i], ys[i]));
+                if (CHECK(Check::same_bits(point[k], expected) && Check::same_bits(results[k][i], expected))) {
+                    continue;
+                }
+                std::fprintf(stderr, "  %s at x = %g, y = %g\n", related[k], double(xs[i]), double(ys[i]));
+            }
+        }
+    }
+} // namespace
+
+int main() {
+    check_against_functions<double>(Precision::Double, Accuracy::Exact);
+    check_against_functions<double>(Precision::Double, Accuracy::Fast);
+    check_against_functions<float>(Precision::Single, Accuracy::Exact);
+    check_against_functions<double>(Precision::Single, Accuracy::Exact);
+
+    // Formulas sharing subexpressions compile to fewer nodes together than apart; unrelated ones do not.
+    const FusedFunction together{parse_all(Precision::Double, Accuracy::Exact)};
+    CHECK(together.optimization_stats().nodes_after < together.optimization_stats().nodes_before);
+
+    const std::vector unrelated{ShuntingYardAlgorithm::parse_text_input("x + 1"),
+                                ShuntingYardAlgorithm::parse_text_input("y * 2")};
+    const FusedFunction apart{unrelated};
+    CHECK(apart.optimization_stats().nodes_after == apart.optimization_stats().nodes_before);
+
+    return Check::result();
+}
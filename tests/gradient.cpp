@@ -0,0 +1,62 @@
+// Gradients: the value matches eval for double-precision exact functions, and the derivatives are right.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <limits>
+
+using namespace InputHandling;
+
+int main() {
+    constexpr const char *expressions[] = {
+        "x + 0",
+        "x * y - y / 4 + x ^ 2",
+        "sin(x) * cos(y) + tan(x * y)",
+        "sec(x) + csc(y) + cot(x) + sech(y) + csch(x) + coth(y)",
+        "exp(-(x * x + y * y) / 2) + ln(x) + log(y) + x ^ 0.5",
+        "smoothstep(0, 1, x * y) + mix(x, y, 0.5) + clamp(x, -1, 1) + step(x, y)",
+        "max(x, y) - min(x, y) + sign(x) + fract(y) + abs(x) + floor(x) + ceil(y)",
+        "asin(x / 4) + acos(y / 4) + atan(x) + asinh(y) + atanh(x / 4) + acosh(y + 4)",
+        "(x + y) ^ 3 + (x - y) ^ -2 + 2 ^ x",
+    };
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    const double values[]     = {0., -0., 0.5, -1.25, 2., 3.75, 1e300, infinity, -infinity, std::nan("")};
+
+    for (const char *expression : expressions) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(expression);
+        for (const double x : values) {
+            for (const double y : values) {
+                if (CHECK(Check::same_bits(function.eval_with_gradient(x, y).value, function.eval(x, y))) == false) {
+                    std::fprintf(stderr, "  %s at x = %g, y = %g\n", expression, x, y);
+                }
+            }
+        }
+    }
+
+    // Batched gradients are the per-point ones.
+    const auto function = ShuntingYardAlgorithm::parse_text_input("sin(x) * y ^ 2 + exp(x * y)");
+    const double xs[]   = {0., 0.5, -1.25, 2.};
+    const double ys[]   = {1., -0.5, 3., 0.25};
+    Gradient batch[4];
+    function.eval_batch_with_gradient(xs, ys, batch);
+    for (std::size_t i = 0u; i < 4u; ++i) {
+        const Gradient g = function.eval_with_gradient(xs[i], ys[i]);
+        CHECK(Check::same_bits(batch[i].value, g.value) && Check::same_bits(batch[i].dx, g.dx)
+              && Check::same_bits(batch[i].dy, g.dy));
+
+        const double x = xs[i], y = ys[i];
+        CHECK(std::abs(g.dx - (std::cos(x) * y * y + y * std::exp(x * y))) <= 1e-12 * (1. + std::abs(g.dx)));
+        CHECK(std::abs(g.dy - (2. * std::sin(x) * y + x * std::exp(x * y))) <= 1e-12 * (1. + std::abs(g.dy)));
+    }
+
+    // One-sided derivatives at the kinks.
+    const auto kinks = ShuntingYardAlgorithm::parse_text_input("max(x, y) + abs(x - 1)");
+    CHECK(kinks.eval_with_gradient(2., 0.).dx == 2.);
+    CHECK(kinks.eval_with_gradient(0., 2.).dy == 1.);
+    const auto abs = ShuntingYardAlgorithm::parse_text_input("abs(x)");
+    CHECK(abs.eval_with_gradient(0., 0.).dx == 1. && abs.eval_with_gradient(-0., 0.).dx == -1.);
+    CHECK(kinks.eval_with_gradient(1., 0.).dx == 2.);
+
+    return Check::result();
+}
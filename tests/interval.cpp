@@ -0,0 +1,113 @@
+// eval_interval encloses every value taken in the box, and implicit_curve_cells covers the curve.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    // Including the functions with poles, jumps and partial domains, and powers of negative bases.
+    constexpr const char *expressions[] = {
+        "x * y - x / (y + 0.5)",
+        "tan(x) + cot(y)",
+        "sec(x * y) - csc(x)",
+        "floor(x * y) + ceil(x) - trunc(y) + fract(x - y)",
+        "step(x, y) * sign(x) + abs(y)",
+        "smoothstep(-1, 1, x) + mix(x, y, 0.25) + clamp(x * y, -1, 2)",
+        "(x - 1) ^ 3 + x ^ 2 - y ^ -1",
+        "x ^ y",
+        "(-2) ^ y + x ^ 0.5",
+        "exp(x) - ln(y) + log(x * y)",
+        "sin(x * y) * cos(x - y)",
+        "sinh(x) - cosh(y) + tanh(x * y) + sech(x) + csch(y) + coth(x)",
+        "asin(x / 4) + acos(y / 4) + atan(x * y)",
+        "asinh(x) + acosh(y) + atanh(x / 8)",
+        "max(x, y) - min(x * x, y) + x * x + y * y - 1",
+    };
+
+    // A box around a random point, with a width anywhere from 2^-20 to 8.
+    Box random_box(std::mt19937_64 &generator) {
+        std::uniform_real_distribution<double> center{-6., 6.};
+        std::uniform_real_distribution<double> exponent{-20., 3.};
+        const double cx = center(generator), cy = center(generator);
+        const double wx = std::exp2(exponent(generator)), wy = std::exp2(exponent(generator));
+        return {{cx - wx / 2., cx + wx / 2.}, {cy - wy / 2., cy + wy / 2.}};
+    }
+
+    // Points of the box: its corners, the integers in it, where the jumps and integer powers are, and random ones.
+    std::vector<double> sample(const Interval &interval, std::mt19937_64 &generator, std::size_t n) {
+        std::vector<double> points{interval.lo, interval.hi, std::ceil(interval.lo), std::floor(interval.hi)};
+        std::uniform_real_distribution<double> uniform{interval.lo, interval.hi};
+        while (points.size() < n) { points.push_back(uniform(generator)); }
+        std::erase_if(points, [&](double v) { return interval.contains(v) == false; });
+        return points;
+    }
+} // namespace
+
+int main() {
+    std::mt19937_64 generator{1u};
+    for (const char *expression : expressions) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(expression);
+        for (int b = 0; b < 600; ++b) {
+            const Box box      = random_box(generator);
+            const Interval out = function.eval_interval(box.x, box.y);
+            const auto xs      = sample(box.x, generator, 10u);
+            const auto ys      = sample(box.y, generator, 10u);
+            for (const double x : xs) {
+                for (const double y : ys) {
+                    const double value = function.eval(x, y);
+                    if (std::isnan(value) || CHECK(out.contains(value))) { continue; }
+                    std::fprintf(stderr, "  %s = %.17g at x = %.17g, y = %.17g outside [%.17g, %.17g]\n", expression,
+                                 value, x, y, out.lo, out.hi);
+                }
+            }
+        }
+    }
+
+    // Undefined everywhere in the box: nothing to enclose.
+    const auto ln = ShuntingYardAlgorithm::parse_text_input("ln(x) + y");
+    CHECK(ln.eval_interval({-2., -1.}, {0., 1.}).is_empty());
+
+    // The unit circle: every point of it lies in a cell, and every cell is close to it.
+    constexpr uint32_t depth = 7u;
+    const auto circle        = ShuntingYardAlgorithm::parse_text_input("x * x + y * y - 1");
+    const Box region         = {{-2., 2.}, {-2., 2.}};
+    const auto cells         = circle.implicit_curve_cells(region, depth);
+    const double size        = 4. / (1u << depth);
+    CHECK(cells.empty() == false && cells.size() < (1u << depth) * (1u << depth) / 8u);
+
+    const auto covered = [&](double x, double y) {
+        const auto contains = [&](const Box &c) { return c.x.contains(x) && c.y.contains(y); };
+        return std::any_of(cells.begin(), cells.end(), contains);
+    };
+    for (int i = 0; i < 10000; ++i) {
+        const double angle = 2. * std::numbers::pi * i / 10000.;
+        CHECK(covered(std::cos(angle), std::sin(angle)));
+    }
+    for (const auto &cell : cells) {
+        CHECK(cell.x.hi - cell.x.lo == size && cell.y.hi - cell.y.lo == size);
+        const double cx = (cell.x.lo + cell.x.hi) / 2., cy = (cell.y.lo + cell.y.hi) / 2.;
+        CHECK(std::abs(std::hypot(cx, cy) - 1.) <= 2. * size);
+    }
+
+    // A sign change between neighbouring grid points means a cell on the segment between them.
+    for (int i = 0; i < 64; ++i) {
+        for (int j = 0; j + 1 < 64; ++j) {
+            const double x = -2. + 4. * i / 63., y0 = -2. + 4. * j / 63., y1 = -2. + 4. * (j + 1) / 63.;
+            if ((circle.eval(x, y0) < 0.) == (circle.eval(x, y1) < 0.)) { continue; }
+            const double root = std::copysign(std::sqrt(1. - x * x), y0 + y1);
+            CHECK(covered(x, root));
+        }
+    }
+
+    // No zero in the region, no cells.
+    CHECK(ShuntingYardAlgorithm::parse_text_input("x * x + y * y + 1").implicit_curve_cells(region, depth).empty());
+
+    return Check::result();
+}
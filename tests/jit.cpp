@@ -0,0 +1,79 @@
+// The native code of JitFunction, scalar and batched, against ParsedFunction::eval, bit for bit.
+
+#include "../include/math_parser/jit.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    // Every opcode the code generator treats differently, and a few shared subexpressions for Store and Load.
+    constexpr const char *expressions[] = {
+        "x + y",
+        "x - y * 3 / (y + 0.5)",
+        "-x + -(-y)",
+        "max(x, y) - min(x, 2)",
+        "x ^ y + x ^ 2 + x ^ 0.5 + y ^ 3",
+        "sin(x) + cos(y) + tan(x * y)",
+        "sec(x) * csc(y) - cot(x + y)",
+        "sinh(x) + cosh(y) + tanh(x) + sech(y) + csch(x) + coth(y)",
+        "asin(x / 4) + acos(y / 4) + atan(x * y)",
+        "asinh(x) + acosh(y) + atanh(x / 8)",
+        "ln(x) + log(y) + exp(x) + abs(y)",
+        "sign(x) + floor(y) + ceil(x) + trunc(y) + fract(x)",
+        "step(x, y) + clamp(x, -1, 1) + mix(x, y, 0.25) + smoothstep(-1, 1, x)",
+        "sin(x * y) * sin(x * y) + exp(-(x * x + y * y) / 2) * (x * y)",
+        "3 * x ^ 2 + 2 * x - 1 + x / sec(y)",
+        "2.5",
+    };
+
+    std::vector<double> inputs(std::size_t n, uint64_t seed) {
+        std::mt19937_64 generator{seed};
+        std::uniform_real_distribution<double> distribution{-4., 4.};
+
+        std::vector<double> values(n);
+        for (auto &v : values) { v = distribution(generator); }
+
+        constexpr double infinity   = std::numeric_limits<double>::infinity();
+        const double specials[]     = {0., -0., 1., -1., infinity, -infinity, std::nan(""), 1e-310, 1e300};
+        for (std::size_t i = 0u; i < std::size(specials) && i < n; ++i) { values[(i * 7u) % n] = specials[i]; }
+        return values;
+    }
+} // namespace
+
+int main() {
+    const auto xs = inputs(1001u, 1u), ys = inputs(1001u, 2u);
+
+    for (const auto text : expressions) {
+        for (const auto accuracy : {Accuracy::Exact, Accuracy::Fast}) {
+            const auto function = ShuntingYardAlgorithm::parse_text_input(text, Precision::Double, accuracy);
+            const JitFunction jit{function};
+#if defined(__x86_64__) && defined(__unix__)
+            CHECK(jit.is_native());
+#endif
+
+            for (std::size_t i = 0u; i < xs.size(); ++i) {
+                CHECK(Check::same_bits(jit.eval(xs[i], ys[i]), function.eval(xs[i], ys[i])));
+            }
+
+            // Every length up to a few pairs, for the odd last point, then a long run.
+            for (const std::size_t n : {0u, 1u, 2u, 3u, 4u, 5u, 1001u}) {
+                std::vector<double> out(n);
+                jit.eval_batch(std::span{xs}.first(n), std::span{ys}.first(n), out);
+                for (std::size_t i = 0u; i < n; ++i) { CHECK(Check::same_bits(out[i], function.eval(xs[i], ys[i]))); }
+            }
+        }
+    }
+
+    // Programs the code generator does not handle run on the interpreter.
+    const auto single = ShuntingYardAlgorithm::parse_text_input("x * y + 1", Precision::Single);
+    const JitFunction interpreted{single};
+    CHECK(interpreted.is_native() == false);
+    CHECK(interpreted.eval(0.5, 3.) == single.eval(0.5, 3.));
+
+    return Check::result();
+}
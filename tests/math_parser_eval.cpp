@@ -0,0 +1,117 @@
+// The math_parser_eval tool, run on small files: CSV to text and binary to binary, headers, blank lines, malformed
+// rows and bad arguments. Takes the path of the tool as its argument.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    std::string tool;
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+    std::filesystem::path file(const char *name) { return directory / (std::string{"math_parser_eval_test_"} + name); }
+
+    void write(const std::filesystem::path &path, const std::string &contents) {
+        std::ofstream{path, std::ios::binary | std::ios::trunc} << contents;
+    }
+
+    std::string read(const std::filesystem::path &path) {
+        std::ifstream in{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+    struct Run {
+        bool succeeded;
+        std::string out;
+        std::string err;
+    };
+
+    // Runs the tool on `input` with the given arguments before the expression.
+    Run run(const std::string &arguments, const std::string &expression, const std::string &input) {
+        write(file("input"), input);
+        const std::string command = '"' + tool + "\" " + arguments + " \"" + expression + "\" \""
+                                    + file("input").string() + "\" > \"" + file("out").string() + "\" 2> \""
+                                    + file("err").string() + '"';
+        const bool succeeded = std::system(command.c_str()) == 0;
+        return {succeeded, read(file("out")), read(file("err"))};
+    }
+
+    std::string as_bytes(const std::vector<double> &values) {
+        return {reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double)};
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: test_math_parser_eval PATH_TO_MATH_PARSER_EVAL\n");
+        return 1;
+    }
+    tool = argv[1];
+
+    // CSV to text: a header, blank lines and every kind of separator.
+    auto result = run("", "x * y + 1", "x,y\n1,2\n\n3.5;4\r\n  -1 \t 0.25\n\n");
+    CHECK(result.succeeded);
+    CHECK(result.out == "3\n15\n0.75\n");
+
+    // Without a header or a final newline, and over named variables; inf and nan are numbers, not names.
+    result = run("--variables=a,b,c", "a - b * c", "1,2,3\ninf,0,1\n2,1,nan");
+    CHECK(result.succeeded);
+    CHECK(result.out == "-5\ninf\nnan\n");
+    result = run("--variables=a,b,c", "a + b + c", "a b c\n1 2 3\n");
+    CHECK(result.succeeded && result.out == "6\n");
+
+    // A header alone, with or without a newline, is no rows.
+    for (const char *input : {"x,y", "x,y\n", ""}) {
+        result = run("", "x + y", input);
+        CHECK(result.succeeded && result.out.empty());
+    }
+
+    // A first line that is neither numbers nor names is a malformed row, not a header, and so is any later one.
+    result = run("", "x + y", "+1,2\n3,4\n");
+    CHECK(result.succeeded == false && result.out.empty());
+    CHECK(result.err.find("malformed row at byte 0") != std::string::npos);
+    result = run("", "x + y", "x,y\n1,2\n3,four\n");
+    CHECK(result.succeeded == false);
+    CHECK(result.err.find("malformed row at byte 8") != std::string::npos);
+    result = run("", "x + y", "1,2,3\n");
+    CHECK(result.succeeded == false);
+
+    // Binary to binary, over many small chunks and several threads, in input order and bit for bit.
+    const auto function = ShuntingYardAlgorithm::parse_text_input("sin(x) * y - x / 3");
+    std::vector<double> rows, expected;
+    for (int i = 0; i < 1000; ++i) {
+        const double x = i * 0.37 - 150., y = 1. / (i + 1.);
+        rows.insert(rows.end(), {x, y});
+        expected.push_back(function.eval(x, y));
+    }
+    result = run("--input-format=binary --output-format=binary --threads=3 --chunk-size=160",
+                 "sin(x) * y - x / 3",
+                 as_bytes(rows));
+    CHECK(result.succeeded);
+    CHECK(result.out == as_bytes(expected));
+
+    // A binary file that does not hold whole rows.
+    result = run("--input-format=binary", "x + y", as_bytes({1., 2., 3.}));
+    CHECK(result.succeeded == false);
+
+    // Bad arguments print the usage text rather than abort.
+    for (const char *arguments : {"--threads=abc", "--chunk-size=", "--threads=-1", "--precision=half", "--bogus"}) {
+        result = run(arguments, "x + y", "1,2\n");
+        CHECK(result.succeeded == false && result.err.find("usage:") != std::string::npos);
+    }
+
+    // A malformed expression reports where the problem is.
+    result = run("", "x + + y", "1,2\n");
+    CHECK(result.succeeded == false && result.err.find("At character") != std::string::npos);
+
+    for (const char *name : {"input", "out", "err"}) { std::filesystem::remove(file(name)); }
+    return Check::result();
+}
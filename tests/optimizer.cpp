@@ -0,0 +1,168 @@
+// optimize() keeps the value of an exact program, signed zeros included, and only simplifies what it may; the
+// powers it reduces stay within the errors documented in optimizer.cpp.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    // Every rewrite, at the points where it could go wrong.
+    struct Case {
+        const char *text;
+        double (*reference)(double x, double y);
+    };
+    constexpr Case cases[] = {
+        {"x + 0", [](double x, double) { return x + 0.; }},
+        {"0 + x", [](double x, double) { return 0. + x; }},
+        {"x + -0", [](double x, double) { return x + -0.; }},
+        {"x - 0", [](double x, double) { return x - 0.; }},
+        {"x - -0", [](double x, double) { return x - -0.; }},
+        {"0 - (0 - x)", [](double x, double) { return 0. - (0. - x); }},
+        {"-(-x)", [](double x, double) { return -(-x); }},
+        {"-1 * (-1 * x)", [](double x, double) { return -1. * (-1. * x); }},
+        {"x * 1 + y / 1", [](double x, double y) { return x * 1. + y / 1.; }},
+        {"x ^ 1 + y ^ 0", [](double x, double y) { return std::pow(x, 1.) + std::pow(y, 0.); }},
+        {"x ^ 2 - y ^ -1", [](double x, double y) { return x * x - 1. / y; }},
+        {"x / 4 + y / 0.5", [](double x, double y) { return x / 4. + y / 0.5; }},
+        {"x / 3", [](double x, double) { return x / 3.; }},
+        {"x * sec(y)", [](double x, double y) { return x * (1. / std::cos(y)); }},
+        {"x * y + 1", [](double x, double y) { return x * y + 1.; }},
+    };
+
+    std::size_t num_nodes(const char *text, Accuracy accuracy) {
+        return ShuntingYardAlgorithm::parse_text_input(text, Precision::Double, accuracy).program().code.size();
+    }
+
+    // The program of `text` exactly as the parser lowers it, without optimize().
+    _Internal::Program unoptimized(const char *text) { return _Internal::lower_rpn(_Internal::to_rpn(text)); }
+
+    // Distance of `value` from `reference` in units of the last place of `reference`.
+    double ulps(double value, long double reference) {
+        const double rounded = static_cast<double>(reference);
+        if (std::isnan(value) || std::isinf(value) || std::isnan(rounded) || std::isinf(rounded) || rounded == 0.) {
+            return Check::same_bits(value, rounded) ? 0. : std::numeric_limits<double>::infinity();
+        }
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        const double ulp      = std::nextafter(std::abs(rounded), infinity) - std::abs(rounded);
+        return static_cast<double>(std::abs(static_cast<long double>(value) - reference)) / ulp;
+    }
+
+    // Seeded points: half of them in [-4, 4], half spread over the magnitudes from 1e-90 to 1e90, either sign.
+    std::vector<double> random_points(std::size_t n, uint64_t seed) {
+        std::mt19937_64 generator{seed};
+        std::uniform_real_distribution<double> uniform{-4., 4.};
+        std::uniform_real_distribution<double> exponent{-300., 300.};
+
+        std::vector<double> points(n);
+        for (std::size_t i = 0u; i < n; ++i) {
+            const double magnitude = std::exp2(exponent(generator));
+            points[i]              = i % 2u == 0u ? uniform(generator) : std::copysign(magnitude, uniform(generator));
+        }
+        return points;
+    }
+
+    // Rewrites of exact programs that keep every value.
+    constexpr const char *lossless[] = {
+        "x ^ 0 + y / 4",
+        "x / 0.5 - y * 1 + x / 1",
+        "x ^ 1 + -(-y) + (x - -0)",
+        "sin(x) * sin(x) + cos(y) * cos(y)",
+        "x ^ 3 + y ^ 0.5 + x * sec(y)",
+        "exp(x / 8) * y - exp(x / 8)",
+    };
+
+    // Fast reductions of powers and division, against the exact result, with the error optimizer.cpp documents.
+    struct Reduction {
+        const char *text;
+        long double (*exact)(long double x);
+        double bound;
+    };
+    constexpr Reduction reductions[] = {
+        {"x ^ 3", [](long double x) { return x * x * x; }, 2.},
+        {"x ^ 5", [](long double x) { return powl(x, 5); }, 4.},
+        {"x ^ 16", [](long double x) { return powl(x, 16); }, 15.},
+        {"x ^ -2", [](long double x) { return 1 / (x * x); }, 2.},
+        {"x ^ -7", [](long double x) { return powl(x, -7); }, 7.},
+        {"x ^ 0.5", [](long double x) { return sqrtl(x); }, 0.5},
+        {"x ^ -0.5", [](long double x) { return 1 / sqrtl(x); }, 1.5},
+        {"x / 3", [](long double x) { return x / 3; }, 1.5},
+        {"x / 12345.678", [](long double x) { return x / static_cast<long double>(12345.678); }, 1.5},
+    };
+} // namespace
+
+int main() {
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    const double values[]     = {0., -0., 1., -1.5, 3., 1e-310, 1e300, infinity, -infinity, std::nan("")};
+
+    for (const auto &c : cases) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(c.text);
+        for (const double x : values) {
+            for (const double y : values) {
+                const bool same = Check::same_bits(function.eval(x, y), c.reference(x, y));
+                if (CHECK(same) == false) { std::fprintf(stderr, "  %s at x = %g, y = %g\n", c.text, x, y); }
+            }
+        }
+    }
+
+    // Optimized against unoptimized at random points.
+    const auto xs = random_points(100000u, 1u);
+    const auto ys = random_points(100000u, 2u);
+    for (const char *text : lossless) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(text);
+        const auto program  = unoptimized(text);
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            const double expected = _Internal::execute(program.view(), xs[i], ys[i]);
+            const bool same       = Check::same_bits(function.eval(xs[i], ys[i]), expected);
+            if (CHECK(same) == false) { std::fprintf(stderr, "  %s at x = %.17g, y = %.17g\n", text, xs[i], ys[i]); }
+        }
+    }
+
+    // x^2 and x^-1 are computed correctly rounded, at most 1 ulp from pow.
+    const auto square      = ShuntingYardAlgorithm::parse_text_input("x ^ 2");
+    const auto inverse     = ShuntingYardAlgorithm::parse_text_input("x ^ -1");
+    const auto square_pow  = unoptimized("x ^ 2");
+    const auto inverse_pow = unoptimized("x ^ -1");
+    double worst = 0.;
+    for (const double x : xs) {
+        CHECK(Check::same_bits(square.eval(x, 0.), x * x));
+        CHECK(Check::same_bits(inverse.eval(x, 0.), 1. / x));
+        worst = std::max({worst,
+                          ulps(square.eval(x, 0.), _Internal::execute(square_pow.view(), x, 0.)),
+                          ulps(inverse.eval(x, 0.), _Internal::execute(inverse_pow.view(), x, 0.))});
+    }
+    CHECK(worst <= 1.);
+
+    for (const auto &r : reductions) {
+        const auto function = ShuntingYardAlgorithm::parse_text_input(r.text, Precision::Double, Accuracy::Fast);
+        const auto &code    = function.program().code;
+        CHECK(std::none_of(code.begin(), code.end(), [](const auto &ins) { return ins.op == _Internal::OpCode::Pow; }));
+
+        double error = 0., at = 0.;
+        for (std::size_t i = 0u; i < xs.size(); i += 2u) { // Only [-4, 4], away from overflow and underflow.
+            const double e = ulps(function.eval(xs[i], 0.), r.exact(xs[i]));
+            if (e > error) { error = e, at = xs[i]; }
+        }
+        if (CHECK(error <= r.bound) == false) {
+            std::fprintf(stderr, "  %s: %.3f ulp at x = %.17g, documented %.1f\n", r.text, error, at, r.bound);
+        }
+    }
+
+    // The identities that hold for every value are applied in exact programs, the others only in fast ones.
+    CHECK(num_nodes("x + -0", Accuracy::Exact) == 1u);
+    CHECK(num_nodes("x - 0", Accuracy::Exact) == 1u);
+    CHECK(num_nodes("-(-x)", Accuracy::Exact) == 1u);
+    CHECK(num_nodes("x + 0", Accuracy::Exact) == 3u);
+    CHECK(num_nodes("0 - (0 - x)", Accuracy::Exact) > 1u);
+    CHECK(num_nodes("x + 0", Accuracy::Fast) == 1u);
+    CHECK(num_nodes("0 - (0 - x)", Accuracy::Fast) == 1u);
+
+    return Check::result();
+}
@@ -0,0 +1,93 @@
+// ParameterizedFunction against the same text parsed over x, y and the parameters, and set() recomputing only the
+// cached subexpressions that read the parameters it changes.
+
+#include "../include/math_parser/parameterized.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace InputHandling;
+
+namespace {
+    constexpr const char *text             = "x * a + y * exp(-t) + a * t * x + sin(a) ^ 2";
+    constexpr std::string_view names[]     = {"a", "t"};
+    constexpr std::string_view variables[] = {"x", "y", "a", "t"};
+
+    // Instructions of the program whose constant changed.
+    std::size_t num_changed(const _Internal::Program &before, const _Internal::Program &after) {
+        std::size_t changed = 0u;
+        for (std::size_t i = 0u; i < before.code.size(); ++i) {
+            changed += Check::same_bits(before.code[i].value, after.code[i].value) == false;
+        }
+        return changed;
+    }
+
+    // f and the reference over x, y, a and t agree at random points.
+    void check_points(const ParameterizedFunction &f, const ParsedFunction &reference, double a, double t) {
+        std::mt19937_64 generator{7u};
+        std::uniform_real_distribution<double> uniform{-3., 3.};
+        std::vector<double> xs(64u), ys(64u), out(64u);
+        for (std::size_t i = 0u; i < xs.size(); ++i) { xs[i] = uniform(generator), ys[i] = uniform(generator); }
+        xs[0] = 0., ys[0] = -0.;
+
+        f.eval_batch(xs, ys, out);
+        for (std::size_t i = 0u; i < xs.size(); ++i) {
+            const double values[] = {xs[i], ys[i], a, t};
+            const double expected = reference.eval(values);
+            CHECK(Check::same_bits(f.eval(xs[i], ys[i]), expected));
+            CHECK(Check::same_bits(out[i], expected));
+        }
+    }
+} // namespace
+
+int main() {
+    ParameterizedFunction f{text, names};
+    const auto reference = ShuntingYardAlgorithm::parse_text_input(text, variables);
+    const auto a         = f.parameter("a");
+    const auto t         = f.parameter("t");
+
+    // a, exp(-t), a * t and sin(a) ^ 2: everything of the parameters alone that the point-dependent part uses.
+    CHECK(f.num_cached() == 4u);
+    CHECK(f.get(a) == 0. && f.get(t) == 0.);
+    check_points(f, reference, 0., 0.);
+
+    // Changing t updates exp(-t) and a * t, which read it, and leaves a and sin(a) ^ 2 alone.
+    f.set(a, 1.5);
+    auto before = f.program();
+    f.set(t, 0.25);
+    CHECK(num_changed(before, f.program()) == 2u);
+    check_points(f, reference, 1.5, 0.25);
+
+    // Changing a updates a, a * t and sin(a) ^ 2, and leaves exp(-t) alone.
+    before = f.program();
+    f.set(a, -2.);
+    CHECK(num_changed(before, f.program()) == 3u);
+    check_points(f, reference, -2., 0.25);
+
+    // Several at once is the same as one after the other.
+    const ParameterizedFunction::Parameter both[] = {t, a};
+    const double values[]                         = {3., 0.75};
+    f.set(both, values);
+    CHECK(f.get(t) == 3. && f.get(a) == 0.75);
+    check_points(f, reference, 0.75, 3.);
+
+    ParameterizedFunction g{text, names};
+    g.set(a, 0.75);
+    g.set(t, 3.);
+    CHECK(g.program().code.size() == f.program().code.size());
+    CHECK(num_changed(g.program(), f.program()) == 0u);
+
+    // Without parameters in the text there is nothing to cache.
+    const ParameterizedFunction plain{"x * y + 1", names};
+    CHECK(plain.num_cached() == 0u);
+    CHECK(plain.eval(2., 3.) == 7.);
+
+    // A function of the parameters alone is one cached constant.
+    ParameterizedFunction constant{"a * t + 1", names};
+    constant.set(both, values);
+    CHECK(constant.num_cached() == 1u && constant.eval(0., 0.) == 3.25);
+
+    return Check::result();
+}
@@ -0,0 +1,118 @@
+// The grammar: operator precedence, unary minus and whitespace, through ShuntingYardAlgorithm::parse_text_input.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <optional>
+#include <string_view>
+
+using namespace InputHandling;
+
+namespace {
+    double eval(const char *text, double x = 0., double y = 0.) {
+        return ShuntingYardAlgorithm::parse_text_input(text).eval(x, y);
+    }
+
+    using Kind = ParseError::Kind;
+
+    // Malformed formulas, why they are rejected and the offset of the symbol at fault.
+    struct Malformed {
+        const char *text;
+        Kind kind;
+        uint32_t offset;
+    };
+    constexpr Malformed malformed[] = {
+        {"x + (y", Kind::MismatchedParenthesis, 4u},
+        {"x + y)", Kind::MismatchedParenthesis, 5u},
+        {"(x))", Kind::MismatchedParenthesis, 3u},
+        {"x $ y", Kind::UnrecognizedSymbol, 2u},
+        {"1 2", Kind::UnrecognizedSymbol, 2u},
+        {"x + zeta", Kind::UnrecognizedSymbol, 4u},
+        {"", Kind::UnrecognizedSymbol, 0u},
+        {"x+*2", Kind::TooManyOperators, 2u},
+        {"x^^2", Kind::TooManyOperators, 2u},
+        {"*x", Kind::TooManyOperators, 0u},
+        {"x * (/ y)", Kind::TooManyOperators, 5u},
+        {"max(x, *y)", Kind::TooManyOperators, 7u},
+        {"x +", Kind::TooManyOperators, 2u},
+        {"-", Kind::TooManyOperators, 0u},
+        {"max(x)", Kind::IncorrectNumberOfArguments, 0u},
+        {"1 + sin(x, y)", Kind::IncorrectNumberOfArguments, 4u},
+        {"(x, y)", Kind::IncorrectNumberOfArguments, 0u},
+        {"x , y", Kind::IncorrectNumberOfArguments, 2u},
+    };
+
+    // The kind of the exception parse_text_input throws, if any.
+    std::optional<Kind> thrown(const char *text) {
+        try {
+            static_cast<void>(ShuntingYardAlgorithm::parse_text_input(text));
+        } catch (const MismatchedParenthesis &) {
+            return Kind::MismatchedParenthesis;
+        } catch (const UnrecognizedSymbolException &) {
+            return Kind::UnrecognizedSymbol;
+        } catch (const TooManyOperatorsException &) {
+            return Kind::TooManyOperators;
+        } catch (const IncorrectNumberOfArgumentsException &) { return Kind::IncorrectNumberOfArguments; }
+        return std::nullopt;
+    }
+} // namespace
+
+int main() {
+    CHECK(eval("1 + 2 * 3") == 7.);
+    CHECK(eval("2 ^ 3 ^ 2") == 512.);
+    CHECK(eval("-x ^ 2", 3.) == -9.);
+    CHECK(eval("2 ^ -x", 1.) == 0.5);
+    CHECK(eval("x - -y", 1., 2.) == 3.);
+    CHECK(eval("max(x, -y) - min(x, y)", 1., 2.) == 0.);
+    CHECK(eval("-sin(-x)", 1.) == std::sin(1.));
+
+    // Whitespace only separates tokens. Before unary minus became an operator, spaces were removed from the text
+    // first, so "1 2" was the number 12; it is now two operands without an operator between them.
+    CHECK(eval(" \t1\n+\r2 ") == 3.);
+    CHECK(eval("sin (x)", 1.) == std::sin(1.));
+    CHECK_THROWS(eval("1 2"), UnrecognizedSymbolException);
+    CHECK_THROWS(eval("x y"), UnrecognizedSymbolException);
+    CHECK_THROWS(eval("s in(x)"), UnrecognizedSymbolException);
+
+    CHECK_THROWS(eval("(x + y"), MismatchedParenthesis);
+    CHECK_THROWS(eval("x + y)"), MismatchedParenthesis);
+    CHECK_THROWS(eval("x +"), TooManyOperatorsException);
+    CHECK_THROWS(eval("max(x)"), IncorrectNumberOfArgumentsException);
+    CHECK_THROWS(eval("x $ y"), UnrecognizedSymbolException);
+    CHECK_THROWS(eval(""), UnrecognizedSymbolException);
+
+    // try_parse_text_input reports the same errors without throwing, with where they are.
+    for (const auto &m : malformed) {
+        const auto result = ShuntingYardAlgorithm::try_parse_text_input(m.text);
+        if (CHECK(result.has_value() == false) == false) { continue; }
+
+        const bool as_expected = result.error().kind == m.kind && result.error().offset == m.offset;
+        if (CHECK(as_expected) == false) {
+            std::fprintf(stderr, "  \"%s\": kind %u at %u\n", m.text, static_cast<unsigned>(result.error().kind),
+                         result.error().offset);
+        }
+        CHECK(thrown(m.text) == m.kind);
+    }
+
+    constexpr std::string_view ab[] = {"a", "b"};
+    const auto unknown              = ShuntingYardAlgorithm::try_parse_text_input("a * (b + c)", ab);
+    CHECK(unknown.has_value() == false && unknown.error().kind == Kind::UnrecognizedSymbol
+          && unknown.error().offset == 9u);
+    CHECK_THROWS(ShuntingYardAlgorithm::try_parse_text_input("x +").value(), TooManyOperatorsException);
+    CHECK(std::string_view{ShuntingYardAlgorithm::try_parse_text_input("(x").error().message()}
+          == MismatchedParenthesis{}.what());
+
+    const auto parsed = ShuntingYardAlgorithm::try_parse_text_input("max(x, -y) * 2");
+    CHECK(parsed.has_value() && parsed->eval(1., 2.) == 2.);
+
+    // Inputs the program needs when evaluated from a span of values or columns.
+    using InputHandling::_Internal::required_inputs;
+    constexpr std::string_view names[] = {"a", "b", "c"};
+    CHECK(required_inputs(ShuntingYardAlgorithm::parse_text_input("1 + 2").program().view()) == 0u);
+    CHECK(required_inputs(ShuntingYardAlgorithm::parse_text_input("y + 2").program().view()) == 2u);
+    CHECK(required_inputs(ShuntingYardAlgorithm::parse_text_input("a * 2", names).program().view()) == 1u);
+    CHECK(required_inputs(ShuntingYardAlgorithm::parse_text_input("c - a", names).program().view()) == 3u);
+
+    return Check::result();
+}
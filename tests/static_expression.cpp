@@ -0,0 +1,53 @@
+// static_expression: parsed at compile time by the constexpr lexer and parser, and evaluated to the same bits as
+// ParsedFunction::eval.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "../include/math_parser/static_expression.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <limits>
+
+using namespace InputHandling;
+using InputHandling::_Internal::FixedString;
+using InputHandling::_Internal::OpCode;
+
+// The programs exist at compile time.
+static_assert(StaticExpression<"x + 1">::program.code.size() == 3u);
+static_assert(StaticExpression<"x + 1">::program.code[1].op == OpCode::Constant);
+static_assert(StaticExpression<"x + 1">::program.code[1].value == 1.);
+static_assert(StaticExpression<"-x ^ 2">::program.code.back().op == OpCode::Neg);
+static_assert(StaticExpression<"smoothstep(0, 1, x * y)">::program.first.back() == 0u);
+static_assert(StaticExpression<"max(sin(x), 0.25)">::program.code[2].value == 0.25);
+
+namespace {
+    template <FixedString Text> void check_against_parser(std::span<const double> values) {
+        constexpr auto f    = static_expression<Text>;
+        const auto function = ShuntingYardAlgorithm::parse_text_input(Text.view());
+        for (const double x : values) {
+            for (const double y : values) {
+                if (CHECK(Check::same_bits(f(x, y), function.eval(x, y))) == false) {
+                    std::fprintf(stderr, "  %s at x = %g, y = %g\n", Text.text.data(), x, y);
+                }
+            }
+        }
+    }
+} // namespace
+
+int main() {
+    constexpr double infinity = std::numeric_limits<double>::infinity();
+    const double values[]     = {0., -0., 0.5, -1., 2., 1e-310, 1e300, infinity, -infinity, std::nan("")};
+
+    // Including the identities optimize() applies to the parsed function and the static one does not.
+    check_against_parser<"x + 0">(values);
+    check_against_parser<"0 - (0 - x) + -(-y)">(values);
+    check_against_parser<"x * 1 - y / 1 + x ^ 1">(values);
+    check_against_parser<"x ^ 3 + y ^ 0.5 + x ^ 0 + y / 4">(values);
+    check_against_parser<"sin(x) * cos(y) + 2 * 3">(values);
+    check_against_parser<"sec(x) + csc(y) + cot(x) + sech(y) + csch(x) + coth(y)">(values);
+    check_against_parser<"smoothstep(0, 1, x * y) + mix(x, y, 0.5) + clamp(x, -1, 1) + step(x, y)">(values);
+    check_against_parser<"max(x, y) - min(x, y) + sign(x) + fract(y) + abs(x)">(values);
+    check_against_parser<"exp(-(x * x + y * y) / 2) + ln(x) + log(y)">(values);
+
+    return Check::result();
+}
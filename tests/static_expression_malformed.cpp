@@ -0,0 +1,6 @@
+// Must not compile: a malformed literal is a compile error. Built by the static_expression_malformed test, which
+// expects the compiler to fail.
+
+#include "../include/math_parser/static_expression.hpp"
+
+double f(double x, double y) { return InputHandling::static_expression<"sin(x + y">(x, y); }
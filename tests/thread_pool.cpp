@@ -0,0 +1,47 @@
+// ThreadPool::parallel_for: every index once, nested calls, and exceptions thrown by tasks.
+
+#include "../include/math_parser/math_parser.hpp"
+#include "check.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace InputHandling;
+
+int main() {
+    ThreadPool pool{3u};
+
+    std::vector<std::atomic<int>> visits(1000u);
+    pool.parallel_for(visits.size(), [&](std::size_t i) { visits[i].fetch_add(1); });
+    bool once = true;
+    for (const auto &v : visits) { once = once && v.load() == 1; }
+    CHECK(once);
+
+    std::atomic<std::size_t> inner{0u};
+    pool.parallel_for(8u, [&](std::size_t) { pool.parallel_for(16u, [&](std::size_t) { inner.fetch_add(1u); }); });
+    CHECK(inner.load() == 8u * 16u);
+
+    // Whichever task fails first, parallel_for only returns after the others, then rethrows.
+    for (int round = 0; round < 50; ++round) {
+        std::atomic<std::size_t> running{0u};
+        CHECK_THROWS(pool.parallel_for(64u,
+                                       [&](std::size_t i) {
+                                           running.fetch_add(1u);
+                                           if (i % 5u == 0u) {
+                                               running.fetch_sub(1u);
+                                               throw std::runtime_error{"task failed"};
+                                           }
+                                           running.fetch_sub(1u);
+                                       }),
+                     std::runtime_error);
+        CHECK(running.load() == 0u);
+    }
+
+    // The pool is still usable afterwards.
+    std::atomic<std::size_t> after{0u};
+    pool.parallel_for(100u, [&](std::size_t) { after.fetch_add(1u); });
+    CHECK(after.load() == 100u);
+
+    return Check::result();
+}
@@ -0,0 +1,423 @@
+// Evaluates one formula over every row of a CSV or binary file of samples.
+//
+//     math_parser_eval [--input-format=csv|binary] [--output-format=text|binary] [--output=FILE]
+//                      [--variables=NAMES] [--precision=double|single] [--accuracy=exact|fast] [--threads=N]
+//                      [--chunk-size=BYTES] EXPRESSION INPUT
+//
+// A row holds one number per variable: x and y, or the comma-separated NAMES of --variables in that order. CSV
+// fields are separated by commas, semicolons or whitespace; blank lines are skipped, and so is a first line naming
+// the columns, that is one with a field starting with a letter or '_' that is not a number. Any other row that does
+// not parse is an error. Binary input is native doubles, row after row. Text output is one value per line in
+// shortest round-trip form, binary output native doubles. Throughput is reported on stderr.
+//
+// The input is memory-mapped and cut into chunks at row boundaries. Worker threads take chunks in turn and run each
+// through number parsing, batched evaluation and formatting while its data is still in cache; the main thread
+// writes finished chunks in input order, one large write apiece. At most two chunks per worker are in flight, so
+// memory stays bounded whatever the size of the input.
+
+#include "../include/math_parser/math_parser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MATH_PARSER_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using namespace InputHandling;
+
+    struct Options {
+        std::string input_format  = "csv";
+        std::string output_format = "text";
+        std::string output;
+        std::vector<std::string> variables;
+        Precision precision    = Precision::Double;
+        Accuracy accuracy      = Accuracy::Exact;
+        std::size_t threads    = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t chunk_size = std::size_t{4u} << 20u;
+        std::string expression;
+        std::string input;
+    };
+
+    // Read-only contents of a file, memory-mapped where the platform allows it.
+    class MappedFile {
+      public:
+        explicit MappedFile(const std::string &path) {
+#if defined(MATH_PARSER_HAS_MMAP)
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) { throw std::system_error{errno, std::generic_category(), path}; }
+
+            struct stat status;
+            if (::fstat(fd, &status) != 0) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error{error, std::generic_category(), path};
+            }
+
+            length = static_cast<std::size_t>(status.st_size);
+            if (length > 0u) {
+                void *memory = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (memory == MAP_FAILED) {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::system_error{error, std::generic_category(), path};
+                }
+                ::madvise(memory, length, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(memory);
+            }
+            ::close(fd);
+#else
+            std::ifstream in{path, std::ios::binary | std::ios::ate};
+            if (in.is_open() == false) { throw std::system_error{errno, std::generic_category(), path}; }
+
+            buffer.resize(static_cast<std::size_t>(in.tellg()));
+            in.seekg(0);
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            data   = buffer.data();
+            length = buffer.size();
+#endif
+        }
+
+        ~MappedFile() {
+#if defined(MATH_PARSER_HAS_MMAP)
+            if (data) { ::munmap(const_cast<char *>(data), length); }
+#endif
+        }
+
+        MappedFile(const MappedFile &)            = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        std::string_view contents() const { return {data, length}; }
+
+      private:
+        const char *data   = nullptr;
+        std::size_t length = 0u;
+#if defined(MATH_PARSER_HAS_MMAP) == false
+        std::vector<char> buffer;
+#endif
+    };
+
+    bool is_separator(char c) { return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r'; }
+
+    // Whether one of the fields of `line` is a name: it starts with a letter or '_' and is not a number, as inf and
+    // nan are.
+    bool is_header(std::string_view line) {
+        for (auto p = line.begin(); p != line.end();) {
+            if (is_separator(*p)) {
+                ++p;
+                continue;
+            }
+            const auto field_end = std::find_if(p, line.end(), is_separator);
+            const bool named     = std::isalpha(static_cast<unsigned char>(*p)) || *p == '_';
+            double ignored;
+            if (named && std::from_chars(&*p, &*p + (field_end - p), ignored).ptr != &*p + (field_end - p)) {
+                return true;
+            }
+            p = field_end;
+        }
+        return false;
+    }
+
+    // Cuts the input into pieces of about `chunk_size` bytes that end at row boundaries.
+    std::vector<std::string_view> split(std::string_view input, const Options &options, std::size_t row_bytes) {
+        std::vector<std::string_view> chunks;
+        if (options.input_format == "binary") {
+            const auto step = std::max<std::size_t>(1u, options.chunk_size / row_bytes) * row_bytes;
+            for (std::size_t offset = 0u; offset < input.size(); offset += step) {
+                chunks.push_back(input.substr(offset, step));
+            }
+            return chunks;
+        }
+
+        std::size_t start = input.find_first_not_of(" \t\r\n");
+        if (start == std::string_view::npos) { return chunks; }
+        const auto first_end = input.find('\n', start);
+        if (is_header(input.substr(start, first_end == std::string_view::npos ? first_end : first_end - start))) {
+            start = first_end == std::string_view::npos ? input.size() : first_end + 1u;
+        }
+
+        while (start < input.size()) {
+            auto end = start + std::min(options.chunk_size, input.size() - start);
+            if (end < input.size()) {
+                const auto newline = input.find('\n', end);
+                end                = newline == std::string_view::npos ? input.size() : newline + 1u;
+            }
+            chunks.push_back(input.substr(start, end - start));
+            start = end;
+        }
+        return chunks;
+    }
+
+    // Parses the rows of a CSV chunk into one column per variable. Returns the offset of the first malformed row
+    // within the chunk, if any.
+    std::optional<std::size_t> parse_csv(std::string_view chunk, std::vector<std::vector<double>> &columns) {
+        const char *const begin = chunk.data();
+        const char *const end   = begin + chunk.size();
+
+        for (const char *p = begin; p < end;) {
+            const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (line_end == nullptr) { line_end = end; }
+
+            const char *q = p;
+            while (q < line_end && is_separator(*q)) { ++q; }
+            if (q < line_end) {
+                for (auto &column : columns) {
+                    while (q < line_end && is_separator(*q)) { ++q; }
+                    double value;
+                    const auto [next, error] = std::from_chars(q, line_end, value);
+                    if (error != std::errc{}) { return p - begin; }
+
+                    column.push_back(value);
+                    q = next;
+                }
+                while (q < line_end && is_separator(*q)) { ++q; }
+                if (q != line_end) { return p - begin; }
+            }
+            p = line_end + 1;
+        }
+        return std::nullopt;
+    }
+
+    void parse_binary(std::string_view chunk, std::vector<std::vector<double>> &columns) {
+        const auto row_bytes = columns.size() * sizeof(double);
+        for (std::size_t offset = 0u; offset + row_bytes <= chunk.size(); offset += row_bytes) {
+            for (std::size_t k = 0u; k < columns.size(); ++k) {
+                double value;
+                std::memcpy(&value, chunk.data() + offset + k * sizeof(double), sizeof value);
+                columns[k].push_back(value);
+            }
+        }
+    }
+
+    void format(std::span<const double> values, const Options &options, std::vector<char> &out) {
+        if (options.output_format == "binary") {
+            out.resize(values.size() * sizeof(double));
+            std::memcpy(out.data(), values.data(), out.size());
+            return;
+        }
+
+        // The shortest round-trip form of a double takes at most 24 characters.
+        out.resize(values.size() * 25u);
+        char *p = out.data();
+        for (const double value : values) {
+            p    = std::to_chars(p, p + 24, value).ptr;
+            *p++ = '\n';
+        }
+        out.resize(p - out.data());
+    }
+
+    struct Chunk {
+        std::string_view input;
+        std::vector<char> output;
+        std::size_t rows{0u};
+        bool done{false};
+    };
+
+    // A count of at least 1, or nothing if `text` is not a number.
+    std::optional<std::size_t> parse_count(std::string_view text) {
+        std::size_t count;
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), count);
+        if (error != std::errc{} || end != text.data() + text.size()) { return std::nullopt; }
+        return std::max<std::size_t>(1u, count);
+    }
+
+    bool parse_options(int argc, char **argv, Options &options) {
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            const auto value           = [&](std::string_view flag) { return std::string{arg.substr(flag.size())}; };
+
+            if (arg.starts_with("--input-format=")) {
+                options.input_format = value("--input-format=");
+            } else if (arg.starts_with("--output-format=")) {
+                options.output_format = value("--output-format=");
+            } else if (arg.starts_with("--output=")) {
+                options.output = value("--output=");
+            } else if (arg.starts_with("--variables=")) {
+                const auto names = value("--variables=");
+                for (std::size_t start = 0u; start <= names.size();) {
+                    const auto end = std::min(names.find(',', start), names.size());
+                    options.variables.push_back(names.substr(start, end - start));
+                    start = end + 1u;
+                }
+            } else if (arg.starts_with("--precision=")) {
+                const auto precision = value("--precision=");
+                if (precision != "double" && precision != "single") { return false; }
+                options.precision = precision == "single" ? Precision::Single : Precision::Double;
+            } else if (arg.starts_with("--accuracy=")) {
+                const auto accuracy = value("--accuracy=");
+                if (accuracy != "exact" && accuracy != "fast") { return false; }
+                options.accuracy = accuracy == "fast" ? Accuracy::Fast : Accuracy::Exact;
+            } else if (arg.starts_with("--threads=")) {
+                const auto threads = parse_count(value("--threads="));
+                if (threads.has_value() == false) { return false; }
+                options.threads = *threads;
+            } else if (arg.starts_with("--chunk-size=")) {
+                const auto chunk_size = parse_count(value("--chunk-size="));
+                if (chunk_size.has_value() == false) { return false; }
+                options.chunk_size = *chunk_size;
+            } else if (arg.starts_with("--")) {
+                std::cerr << "Unknown argument: " << arg << '\n';
+                return false;
+            } else {
+                positional.emplace_back(arg);
+            }
+        }
+        if (positional.size() != 2u) { return false; }
+
+        options.expression = positional[0];
+        options.input      = positional[1];
+        return (options.input_format == "csv" || options.input_format == "binary")
+               && (options.output_format == "text" || options.output_format == "binary");
+    }
+
+    int run(const Options &options) {
+        using Clock      = std::chrono::steady_clock;
+        const auto start = Clock::now();
+
+        const std::vector<std::string_view> names(options.variables.begin(), options.variables.end());
+        // No names parses over x and y.
+        const auto parsed = ShuntingYardAlgorithm::try_parse_text_input(
+            options.expression, names, options.precision, options.accuracy);
+        if (parsed.has_value() == false) {
+            std::cerr << "math_parser_eval: " << parsed.error().message() << " At character " << parsed.error().offset
+                      << " of the expression.\n";
+            return 1;
+        }
+        const auto &function = *parsed;
+        const std::size_t num_columns = names.empty() ? 2u : names.size();
+
+        const MappedFile file{options.input};
+        const auto input = file.contents();
+        if (options.input_format == "binary" && input.size() % (num_columns * sizeof(double)) != 0u) {
+            std::cerr << "math_parser_eval: " << options.input << " does not hold whole rows of " << num_columns
+                      << " doubles\n";
+            return 1;
+        }
+
+        std::FILE *out = options.output.empty() ? stdout : std::fopen(options.output.c_str(), "wb");
+        if (out == nullptr) { throw std::system_error{errno, std::generic_category(), options.output}; }
+        std::setvbuf(out, nullptr, _IONBF, 0); // Every write is a whole chunk already.
+
+        std::vector<Chunk> chunks;
+        for (const auto piece : split(input, options, num_columns * sizeof(double))) {
+            chunks.push_back(Chunk{.input = piece, .output = {}, .rows = 0u, .done = false});
+        }
+
+        const std::size_t window = 2u * options.threads;
+        std::atomic<std::size_t> next{0u};
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::size_t written = 0u;
+        std::string failure;
+
+        const auto work = [&] {
+            std::vector<std::vector<double>> columns(num_columns);
+            std::vector<std::span<const double>> spans(num_columns);
+            std::vector<double> values;
+
+            for (std::size_t i = next++; i < chunks.size(); i = next++) {
+                {
+                    std::unique_lock lock{mutex};
+                    changed.wait(lock, [&] { return i < written + window || failure.empty() == false; });
+                    if (failure.empty() == false) { return; }
+                }
+
+                auto &chunk = chunks[i];
+                for (auto &column : columns) { column.clear(); }
+                if (options.input_format == "binary") {
+                    parse_binary(chunk.input, columns);
+                } else if (const auto error = parse_csv(chunk.input, columns)) {
+                    std::lock_guard lock{mutex};
+                    failure = "malformed row at byte " + std::to_string(chunk.input.data() + *error - input.data());
+                    changed.notify_all();
+                    return;
+                }
+
+                chunk.rows = columns.front().size();
+                values.resize(chunk.rows);
+                std::copy(columns.begin(), columns.end(), spans.begin());
+                function.eval_columns(spans, values);
+                format(values, options, chunk.output);
+
+                std::lock_guard lock{mutex};
+                chunk.done = true;
+                changed.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0u; t < std::min(options.threads, chunks.size()); ++t) { workers.emplace_back(work); }
+
+        std::size_t rows = 0u;
+        for (auto &chunk : chunks) {
+            {
+                std::unique_lock lock{mutex};
+                changed.wait(lock, [&] { return chunk.done || failure.empty() == false; });
+                if (failure.empty() == false) { break; }
+            }
+
+            if (std::fwrite(chunk.output.data(), 1u, chunk.output.size(), out) != chunk.output.size()) {
+                std::lock_guard lock{mutex};
+                failure = std::strerror(errno);
+                changed.notify_all();
+                break;
+            }
+            rows += chunk.rows;
+            std::vector<char>{}.swap(chunk.output);
+
+            std::lock_guard lock{mutex};
+            ++written;
+            changed.notify_all();
+        }
+        for (auto &worker : workers) { worker.join(); }
+
+        if (out != stdout) { std::fclose(out); }
+        if (failure.empty() == false) {
+            std::cerr << "math_parser_eval: " << failure << '\n';
+            return 1;
+        }
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        std::fprintf(stderr, "%zu rows in %.3f s, %.0f rows/s\n", rows, seconds, seconds > 0. ? rows / seconds : 0.);
+        return 0;
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (parse_options(argc, argv, options) == false) {
+        std::cerr << "usage: math_parser_eval [--input-format=csv|binary] [--output-format=text|binary] "
+                     "[--output=FILE] [--variables=NAMES] [--precision=double|single] [--accuracy=exact|fast] "
+                     "[--threads=N] [--chunk-size=BYTES] EXPRESSION INPUT\n";
+        return 2;
+    }
+
+    try {
+        return run(options);
+    } catch (const std::exception &error) {
+        std::cerr << "math_parser_eval: " << error.what() << '\n';
+        return 1;
+    }
+}